@@ -0,0 +1,692 @@
+#include "Platform.h"
+#include "RegexMatcher.h"
+#include "RenamerService.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+namespace Platform = RenamerCore::Platform;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> sizes { 10000, 100000, 1000000 };
+    std::string distribution = "mixed";
+    std::size_t iterations = 3;
+    fs::path root;
+    std::string label;
+    std::string outputPath;
+    std::size_t parallelSortThreshold = RenamerCore::DirectorySnapshot::DEFAULT_PARALLEL_SORT_THRESHOLD;
+    std::size_t parallelMatchThreshold = RenamerCore::CollectOptions::DEFAULT_PARALLEL_MATCH_THRESHOLD;
+    bool skipRename = false;
+    bool keep = false;
+};
+
+struct Scenario {
+    std::string name;
+    std::wstring pattern;
+    std::wstring replacement;
+    bool useRegex;
+    bool ignoreCase;
+    std::size_t maxOperations;
+    bool recursive = false;
+    // Collects the way the preview does: streamed, with a sampled match
+    // estimate and a PlanView. Reports "first_batch", "estimate" and "page",
+    // the time to materialize a page from the middle of the view.
+    bool streaming = false;
+};
+
+// Phase name -> one sample per iteration, in milliseconds.
+using PhaseSamples = std::map<std::string, std::vector<double>>;
+
+struct ScenarioReport {
+    std::size_t entries;
+    std::string scenario;
+    std::size_t matches;
+    PhaseSamples phases;
+    // Names the regex prefilter rejected in the last iteration.
+    std::size_t prefilterRejected = 0;
+    // Sampled estimate of `matches` in the last iteration, 0 without one.
+    std::size_t estimatedMatches = 0;
+};
+
+double ToMilliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double Median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const std::size_t middle = values.size() / 2;
+    return (values.size() % 2 == 1) ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+std::wstring FormatNumber(std::size_t value, int width) {
+    std::wstring digits = std::to_wstring(value);
+    if (static_cast<int>(digits.size()) < width) {
+        digits.insert(0, static_cast<std::size_t>(width) - digits.size(), L'0');
+    }
+    return digits;
+}
+
+struct GeneratedEntry {
+    std::wstring name;
+    bool isDirectory;
+};
+
+GeneratedEntry MakeEntryName(const std::string& distribution, std::size_t index, std::mt19937& random) {
+    if (distribution == "sequential") {
+        return { L"IMG_" + FormatNumber(index, 7) + L".jpg", false };
+    }
+
+    static const wchar_t* const kWords[] = {
+        L"report", L"invoice", L"holiday", L"scan", L"draft", L"backup", L"photo", L"notes"
+    };
+    static const wchar_t* const kCyrillicWords[] = {
+        L"Фото", L"Отчёт", L"Документ", L"Скан", L"Черновик", L"Архив"
+    };
+
+    const unsigned bucket = random() % 100;
+    const std::wstring number = std::to_wstring(index);
+    const std::wstring word = kWords[random() % (sizeof(kWords) / sizeof(kWords[0]))];
+
+    if (distribution == "unicode") {
+        const std::wstring cyrillic = kCyrillicWords[random() % (sizeof(kCyrillicWords) / sizeof(kCyrillicWords[0]))];
+        if (bucket < 40) {
+            return { L"IMG_" + number + L".jpg", false };
+        }
+        if (bucket < 80) {
+            return { cyrillic + L"_" + number + L".jpg", false };
+        }
+        if (bucket < 95) {
+            return { cyrillic + L" " + word + L" " + number + L".docx", false };
+        }
+        return { L"Папка_" + number, true };
+    }
+
+    if (bucket < 40) {
+        return { L"IMG_" + number + L".jpg", false };
+    }
+    if (bucket < 60) {
+        return { L"DSC" + FormatNumber(index, 7) + L".JPG", false };
+    }
+    if (bucket < 80) {
+        return { word + L" v" + number + L" final.docx", false };
+    }
+    if (bucket < 95) {
+        return { L"img_" + word + L"_" + number + L".png", false };
+    }
+    return { L"folder_" + number, true };
+}
+
+bool GenerateFolder(const fs::path& folder, std::size_t count, const std::string& distribution) {
+    std::error_code ec;
+    fs::remove_all(folder, ec);
+    if (!fs::create_directories(folder, ec) || ec) {
+        return false;
+    }
+
+    std::mt19937 random(12345);
+    for (std::size_t index = 0; index < count; ++index) {
+        const GeneratedEntry entry = MakeEntryName(distribution, index, random);
+        const fs::path entryPath = folder / Platform::ToPath(entry.name);
+        if (entry.isDirectory) {
+            fs::create_directory(entryPath, ec);
+            if (ec) {
+                return false;
+            }
+            continue;
+        }
+
+        std::ofstream file(entryPath, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Same entries as GenerateFolder, spread over two levels of subfolders with
+// kTreeFanout entries each.
+bool GenerateTree(const fs::path& folder, std::size_t count, const std::string& distribution) {
+    constexpr std::size_t kTreeFanout = 256;
+
+    std::error_code ec;
+    fs::remove_all(folder, ec);
+    if (!fs::create_directories(folder, ec) || ec) {
+        return false;
+    }
+
+    std::mt19937 random(12345);
+    for (std::size_t index = 0; index < count; ++index) {
+        const std::size_t leaf = index / kTreeFanout;
+        const fs::path parent = folder
+            / Platform::ToPath(L"group_" + FormatNumber(leaf / kTreeFanout, 4))
+            / Platform::ToPath(L"IMG_part_" + FormatNumber(leaf % kTreeFanout, 4));
+        if (index % kTreeFanout == 0) {
+            fs::create_directories(parent, ec);
+            if (ec) {
+                return false;
+            }
+        }
+
+        const GeneratedEntry entry = MakeEntryName(distribution, index, random);
+        const fs::path entryPath = parent / Platform::ToPath(entry.name);
+        if (entry.isDirectory) {
+            fs::create_directory(entryPath, ec);
+            if (ec) {
+                return false;
+            }
+            continue;
+        }
+
+        std::ofstream file(entryPath, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct RegexPassTimes {
+    Clock::duration twoPass;
+    Clock::duration singlePass;
+};
+
+// Replays the regex step over the listing both ways: the former
+// regex_search + regex_replace pair and the single pass of RegexMatcher.
+RegexPassTimes CompareRegexPasses(const RenamerCore::DirectorySnapshot& listing, const Scenario& scenario) {
+    const RenamerCore::EntryArena& arena = listing.GetArena();
+    auto flags = std::regex_constants::ECMAScript;
+    if (scenario.ignoreCase) {
+        flags |= std::regex_constants::icase;
+    }
+    const std::wregex regex(scenario.pattern, flags);
+    const RenamerCore::RegexMatcher matcher(scenario.pattern, scenario.ignoreCase);
+    const RenamerCore::ReplacementTemplate replacement(scenario.replacement);
+    std::wstring newName;
+
+    const Clock::time_point twoPassStart = Clock::now();
+    for (const RenamerCore::DirectoryEntry& entry : listing.GetEntries()) {
+        const std::wstring_view name = arena.GetName(entry);
+        if (!std::regex_search(name.data(), name.data() + name.size(), regex)) {
+            continue;
+        }
+        newName.clear();
+        std::regex_replace(std::back_inserter(newName), name.data(), name.data() + name.size(), regex, scenario.replacement);
+    }
+
+    const Clock::time_point singlePassStart = Clock::now();
+    for (const RenamerCore::DirectoryEntry& entry : listing.GetEntries()) {
+        matcher.ReplaceAll(arena.GetName(entry), replacement, newName);
+    }
+
+    return { singlePassStart - twoPassStart, Clock::now() - singlePassStart };
+}
+
+ScenarioReport RunCollectScenario(const std::wstring& folder,
+                                  std::size_t entries,
+                                  const Scenario& scenario,
+                                  std::size_t iterations,
+                                  std::size_t parallelSortThreshold,
+                                  std::size_t parallelMatchThreshold,
+                                  RenamerCore::DirectorySnapshot* snapshot = nullptr) {
+    ScenarioReport report { entries, scenario.name, 0, {} };
+    RenamerCore::DirectorySnapshot localSnapshot;
+    localSnapshot.SetParallelSortThreshold(parallelSortThreshold);
+
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration) {
+        if (!snapshot) {
+            localSnapshot.Invalidate();
+        }
+
+        RenamerCore::CollectOptions collectOptions { scenario.useRegex, scenario.ignoreCase, scenario.recursive, scenario.maxOperations, {}, parallelMatchThreshold };
+        if (scenario.streaming) {
+            collectOptions.onProgress = [](const RenamerCore::CollectProgress&) {};
+            collectOptions.estimateTimeLimit = std::chrono::milliseconds(20);
+            collectOptions.collectView = true;
+        }
+
+        const Clock::time_point start = Clock::now();
+        const RenamerCore::CollectResult result = RenamerCore::CollectOperations(
+            snapshot ? *snapshot : localSnapshot,
+            folder,
+            scenario.pattern,
+            scenario.replacement,
+            collectOptions
+        );
+        const Clock::duration total = Clock::now() - start;
+
+        report.matches = result.totalCount;
+        report.prefilterRejected = result.stats.prefilterRejected;
+        report.estimatedMatches = result.stats.estimate.count;
+        report.phases["enumerate"].push_back(ToMilliseconds(result.stats.enumerateTime));
+        report.phases["sort"].push_back(ToMilliseconds(result.stats.sortTime));
+        report.phases["match"].push_back(ToMilliseconds(result.stats.matchTime));
+        report.phases["compile"].push_back(ToMilliseconds(result.stats.compileTime));
+        report.phases["total"].push_back(ToMilliseconds(total));
+        if (scenario.streaming) {
+            // Time until the first rows were available, batch or final result.
+            const bool hadBatch = result.stats.firstBatchTime.count() != 0;
+            report.phases["first_batch"].push_back(ToMilliseconds(hadBatch ? result.stats.firstBatchTime : total));
+            report.phases["estimate"].push_back(ToMilliseconds(result.stats.estimateTime));
+            if (result.view) {
+                constexpr std::size_t kPageSize = 256;
+                const Clock::time_point pageStart = Clock::now();
+                const RenamerCore::RenamePlan page = result.view->GetRange(result.view->size() / 2, kPageSize);
+                report.phases["page"].push_back(ToMilliseconds(Clock::now() - pageStart));
+            }
+        }
+
+        if (scenario.useRegex && !scenario.recursive) {
+            const RegexPassTimes passes = CompareRegexPasses(snapshot ? *snapshot : localSnapshot, scenario);
+            report.phases["regex_two_pass"].push_back(ToMilliseconds(passes.twoPass));
+            report.phases["regex_single_pass"].push_back(ToMilliseconds(passes.singlePass));
+            report.phases["regex_saved"].push_back(ToMilliseconds(passes.twoPass - passes.singlePass));
+        }
+    }
+
+    return report;
+}
+
+bool RunRenamePass(const std::wstring& folder,
+                   const std::wstring& pattern,
+                   const std::wstring& replacement,
+                   ScenarioReport& report) {
+    const Clock::time_point start = Clock::now();
+    const RenamerCore::CollectResult collectResult = RenamerCore::CollectOperations(folder, pattern, replacement, false, false);
+    const Clock::time_point executeStart = Clock::now();
+    const RenamerCore::ExecuteResult executeResult = RenamerCore::ExecuteRename(collectResult.operations);
+    const Clock::time_point end = Clock::now();
+
+    if (executeResult.status == RenamerCore::ExecuteStatus::Error) {
+        std::fprintf(stderr, "rename failed: %ls\n", executeResult.message.c_str());
+        return false;
+    }
+
+    report.matches = executeResult.renamedCount;
+    report.phases["collect"].push_back(ToMilliseconds(executeStart - start));
+    report.phases["validate"].push_back(ToMilliseconds(executeResult.stats.validateTime));
+    report.phases["stage"].push_back(ToMilliseconds(executeResult.stats.stageTime));
+    report.phases["commit"].push_back(ToMilliseconds(executeResult.stats.commitTime));
+    report.phases["execute"].push_back(ToMilliseconds(end - executeStart));
+    report.phases["total"].push_back(ToMilliseconds(end - start));
+    return true;
+}
+
+// Reads the deltas for a batch of file operations the way a watcher would:
+// from inotify on Linux, synthesized elsewhere.
+class DeltaSource {
+public:
+    explicit DeltaSource(const fs::path& folder) {
+#ifdef __linux__
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd >= 0) {
+            inotify_add_watch(m_fd, folder.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+        }
+#else
+        (void)folder;
+#endif
+    }
+
+    ~DeltaSource() {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+#endif
+    }
+
+    DeltaSource(const DeltaSource&) = delete;
+    DeltaSource& operator=(const DeltaSource&) = delete;
+
+    bool Collect(const std::vector<RenamerCore::FolderChange>& expected, std::vector<RenamerCore::FolderChange>& changes) {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            std::vector<char> buffer(64 * 1024);
+            bool complete = true;
+            for (;;) {
+                const ssize_t bytesRead = read(m_fd, buffer.data(), buffer.size());
+                if (bytesRead <= 0) {
+                    break;
+                }
+                complete = Platform::ParseFolderChanges(buffer.data(), static_cast<std::size_t>(bytesRead), changes) && complete;
+            }
+            return complete;
+        }
+#endif
+        changes = expected;
+        return true;
+    }
+
+private:
+#ifdef __linux__
+    int m_fd = -1;
+#endif
+};
+
+ScenarioReport RunSnapshotDeltaScenario(const std::wstring& folderText, std::size_t entries, std::size_t iterations) {
+    constexpr std::size_t kDeltaCount = 100;
+    ScenarioReport report { entries, "snapshot_delta", 0, {} };
+    const fs::path folder = Platform::ToPath(folderText);
+
+    RenamerCore::DirectorySnapshot snapshot;
+    snapshot.Refresh(folder);
+    DeltaSource source(folder);
+
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration) {
+        std::vector<RenamerCore::FolderChange> expectedAdds;
+        std::vector<RenamerCore::FolderChange> expectedRemoves;
+        for (std::size_t index = 0; index < kDeltaCount; ++index) {
+            const std::wstring name = L"IMG_delta_" + std::to_wstring(iteration) + L"_" + std::to_wstring(index) + L".jpg";
+            std::ofstream file(folder / Platform::ToPath(name), std::ios::binary);
+            expectedAdds.push_back({ RenamerCore::FolderChangeAction::Added, name });
+            expectedRemoves.push_back({ RenamerCore::FolderChangeAction::Removed, name });
+        }
+
+        std::vector<RenamerCore::FolderChange> changes;
+        const bool complete = source.Collect(expectedAdds, changes);
+        Clock::time_point start = Clock::now();
+        const bool applied = complete && snapshot.ApplyChanges(changes);
+        report.phases["apply_add"].push_back(ToMilliseconds(Clock::now() - start));
+
+        const std::size_t patchedCount = snapshot.GetEntries().size();
+        RenamerCore::DirectorySnapshot fresh;
+        start = Clock::now();
+        fresh.Refresh(folder);
+        report.phases["rescan"].push_back(ToMilliseconds(Clock::now() - start));
+        if (!applied || patchedCount != fresh.GetEntries().size()) {
+            std::fprintf(stderr, "snapshot delta mismatch: patched=%zu rescanned=%zu\n", patchedCount, fresh.GetEntries().size());
+        }
+
+        for (const RenamerCore::FolderChange& change : expectedRemoves) {
+            std::error_code ec;
+            fs::remove(folder / Platform::ToPath(change.name), ec);
+        }
+
+        changes.clear();
+        source.Collect(expectedRemoves, changes);
+        start = Clock::now();
+        snapshot.ApplyChanges(changes);
+        report.phases["apply_remove"].push_back(ToMilliseconds(Clock::now() - start));
+        report.matches = changes.size();
+    }
+
+    return report;
+}
+
+std::string JsonEscape(const std::string& text) {
+    std::string escaped;
+    for (const char ch : text) {
+        switch (ch) {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            escaped += ch;
+            break;
+        }
+    }
+    return escaped;
+}
+
+std::string FormatJson(const BenchOptions& options, const std::vector<ScenarioReport>& reports) {
+    std::ostringstream json;
+    json.precision(3);
+    json << std::fixed;
+
+    json << "{\n";
+    json << "  \"label\": \"" << JsonEscape(options.label) << "\",\n";
+    json << "  \"distribution\": \"" << JsonEscape(options.distribution) << "\",\n";
+    json << "  \"iterations\": " << options.iterations << ",\n";
+    json << "  \"threads\": " << RenamerCore::ThreadPool::Shared().GetThreadCount() << ",\n";
+    json << "  \"parallel_sort_threshold\": " << options.parallelSortThreshold << ",\n";
+    json << "  \"parallel_match_threshold\": " << options.parallelMatchThreshold << ",\n";
+    json << "  \"results\": [\n";
+
+    for (std::size_t reportIndex = 0; reportIndex < reports.size(); ++reportIndex) {
+        const ScenarioReport& report = reports[reportIndex];
+        json << "    {\n";
+        json << "      \"entries\": " << report.entries << ",\n";
+        json << "      \"scenario\": \"" << JsonEscape(report.scenario) << "\",\n";
+        json << "      \"matches\": " << report.matches << ",\n";
+        json << "      \"prefilter_rejected\": " << report.prefilterRejected << ",\n";
+        json << "      \"estimated_matches\": " << report.estimatedMatches << ",\n";
+        json << "      \"phases\": {\n";
+
+        std::size_t phaseIndex = 0;
+        for (const auto& [phase, samples] : report.phases) {
+            json << "        \"" << JsonEscape(phase) << "\": { "
+                 << "\"min_ms\": " << *std::min_element(samples.begin(), samples.end()) << ", "
+                 << "\"median_ms\": " << Median(samples) << ", "
+                 << "\"max_ms\": " << *std::max_element(samples.begin(), samples.end()) << " }";
+            json << (++phaseIndex < report.phases.size() ? ",\n" : "\n");
+        }
+
+        json << "      }\n";
+        json << "    }" << (reportIndex + 1 < reports.size() ? ",\n" : "\n");
+    }
+
+    json << "  ]\n";
+    json << "}\n";
+    return json.str();
+}
+
+void PrintSummary(const ScenarioReport& report) {
+    std::fprintf(stderr, "%9zu  %-16s matches=%-9zu", report.entries, report.scenario.c_str(), report.matches);
+    if (report.estimatedMatches != 0) {
+        std::fprintf(stderr, " estimated=%zu", report.estimatedMatches);
+    }
+    for (const auto& [phase, samples] : report.phases) {
+        std::fprintf(stderr, " %s=%.2fms", phase.c_str(), Median(samples));
+    }
+    std::fprintf(stderr, "\n");
+}
+
+std::vector<std::size_t> ParseSizes(const std::string& text) {
+    std::vector<std::size_t> sizes;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            sizes.push_back(static_cast<std::size_t>(std::strtoull(item.c_str(), nullptr, 10)));
+        }
+    }
+    return sizes;
+}
+
+fs::path DefaultRoot() {
+    std::error_code ec;
+#ifndef _WIN32
+    if (fs::is_directory("/dev/shm", ec)) {
+        return "/dev/shm";
+    }
+#endif
+    return fs::temp_directory_path(ec);
+}
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "Usage: renamer_bench [options]\n"
+        "  --sizes N[,N...]        entry counts (default 10000,100000,1000000)\n"
+        "  --distribution NAME     sequential | mixed | unicode (default mixed)\n"
+        "  --iterations N          runs per scenario (default 3)\n"
+        "  --root DIR              where test folders are created (default /dev/shm or temp)\n"
+        "  --label TEXT            free-form label stored in the JSON (e.g. commit id)\n"
+        "  --output FILE           write JSON to FILE instead of stdout\n"
+        "  --parallel-sort-threshold N\n"
+        "                          entries from which sorting runs on the pool, 0 = never\n"
+        "  --parallel-match-threshold N\n"
+        "                          entries from which matching runs on the pool, 0 = never\n"
+        "  --skip-rename           do not run the ExecuteRename scenario\n"
+        "  --keep                  keep generated folders\n");
+}
+
+bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int index = 1; index < argc; ++index) {
+        const std::string argument = argv[index];
+        const bool hasValue = index + 1 < argc;
+
+        if (argument == "--sizes" && hasValue) {
+            options.sizes = ParseSizes(argv[++index]);
+        } else if (argument == "--distribution" && hasValue) {
+            options.distribution = argv[++index];
+        } else if (argument == "--iterations" && hasValue) {
+            options.iterations = std::max<std::size_t>(1, std::strtoull(argv[++index], nullptr, 10));
+        } else if (argument == "--root" && hasValue) {
+            options.root = argv[++index];
+        } else if (argument == "--label" && hasValue) {
+            options.label = argv[++index];
+        } else if (argument == "--output" && hasValue) {
+            options.outputPath = argv[++index];
+        } else if (argument == "--parallel-sort-threshold" && hasValue) {
+            options.parallelSortThreshold = static_cast<std::size_t>(std::strtoull(argv[++index], nullptr, 10));
+        } else if (argument == "--parallel-match-threshold" && hasValue) {
+            options.parallelMatchThreshold = static_cast<std::size_t>(std::strtoull(argv[++index], nullptr, 10));
+        } else if (argument == "--skip-rename") {
+            options.skipRename = true;
+        } else if (argument == "--keep") {
+            options.keep = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (options.distribution != "sequential" && options.distribution != "mixed" && options.distribution != "unicode") {
+        return false;
+    }
+
+    if (options.root.empty()) {
+        options.root = DefaultRoot();
+    }
+
+    return !options.sizes.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    const std::vector<Scenario> scenarios = {
+        { "literal", L"IMG", L"PIC", false, false, 0 },
+        { "literal_preview", L"IMG", L"PIC", false, false, 400 },
+        { "ignore_case", L"img", L"pic", false, true, 0 },
+        { "regex", L"IMG_(\\d+)", L"PIC_$1", true, false, 0 },
+        { "regex_ignore_case", L"img_(\\d+)", L"pic_$1", true, true, 0 },
+        { "regex_preview_stream", L"IMG_(\\d+)", L"PIC_$1", true, false, 400, false, true },
+    };
+
+    std::vector<ScenarioReport> reports;
+
+    for (const std::size_t size : options.sizes) {
+        const fs::path folder = options.root / ("renamer_bench_" + std::to_string(size));
+        std::fprintf(stderr, "generating %zu entries in %s\n", size, folder.string().c_str());
+        if (!GenerateFolder(folder, size, options.distribution)) {
+            std::fprintf(stderr, "failed to generate %s\n", folder.string().c_str());
+            return 1;
+        }
+
+        const std::wstring folderText = Platform::ToWide(folder);
+        for (const Scenario& scenario : scenarios) {
+            reports.push_back(RunCollectScenario(folderText, size, scenario, options.iterations, options.parallelSortThreshold, options.parallelMatchThreshold));
+            PrintSummary(reports.back());
+        }
+
+        RenamerCore::DirectorySnapshot snapshot;
+        RenamerCore::CollectOperations(snapshot, folderText, L"", L"", false, false, 1);
+        for (const Scenario& scenario : scenarios) {
+            Scenario warm = scenario;
+            warm.name += "_snapshot";
+            reports.push_back(RunCollectScenario(folderText, size, warm, options.iterations, options.parallelSortThreshold, options.parallelMatchThreshold, &snapshot));
+            PrintSummary(reports.back());
+        }
+
+        reports.push_back(RunSnapshotDeltaScenario(folderText, size, options.iterations));
+        PrintSummary(reports.back());
+
+        const fs::path treeFolder = options.root / ("renamer_bench_tree_" + std::to_string(size));
+        if (!GenerateTree(treeFolder, size, options.distribution)) {
+            std::fprintf(stderr, "failed to generate %s\n", treeFolder.string().c_str());
+            return 1;
+        }
+
+        const std::wstring treeFolderText = Platform::ToWide(treeFolder);
+        const Scenario recursiveScenarios[] = {
+            { "recursive_literal", L"IMG", L"PIC", false, false, 0, true },
+            { "recursive_regex", L"IMG_(\\d+)", L"PIC_$1", true, false, 0, true },
+        };
+        for (const Scenario& scenario : recursiveScenarios) {
+            reports.push_back(RunCollectScenario(treeFolderText, size, scenario, options.iterations, options.parallelSortThreshold, options.parallelMatchThreshold));
+            PrintSummary(reports.back());
+        }
+
+        if (!options.skipRename) {
+            ScenarioReport forward { size, "rename", 0, {} };
+            ScenarioReport backward { size, "rename_back", 0, {} };
+            for (std::size_t iteration = 0; iteration < options.iterations; ++iteration) {
+                if (!RunRenamePass(folderText, L"IMG_", L"PIC_", forward)
+                    || !RunRenamePass(folderText, L"PIC_", L"IMG_", backward)) {
+                    return 1;
+                }
+            }
+            reports.push_back(forward);
+            PrintSummary(reports.back());
+            reports.push_back(backward);
+            PrintSummary(reports.back());
+        }
+
+        if (!options.keep) {
+            std::error_code ec;
+            fs::remove_all(folder, ec);
+            fs::remove_all(treeFolder, ec);
+        }
+    }
+
+    const std::string json = FormatJson(options, reports);
+    if (options.outputPath.empty()) {
+        std::fwrite(json.data(), 1, json.size(), stdout);
+    } else {
+        std::ofstream output(options.outputPath, std::ios::binary);
+        output << json;
+        if (!output) {
+            std::fprintf(stderr, "failed to write %s\n", options.outputPath.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
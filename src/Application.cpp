@@ -2,6 +2,7 @@
 #include "Application.h"
 
 #include "ExplorerPathProvider.h"
+#include "Platform.h"
 #include "RenamerService.h"
 #include "ToolTip.h"
 #include "UiRenderer.h"
@@ -19,6 +20,8 @@
 #include <cstdint>
 #include <cwctype>
 #include <filesystem>
+#include <iterator>
+#include <limits>
 
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "gdiplus.lib")
@@ -45,7 +48,8 @@ enum ControlId {
     ID_RENAME_BUTTON = 1007,
     ID_CURRENT_PREVIEW = 1008,
     ID_RESULT_PREVIEW = 1009,
-    ID_HELP_BUTTON = 1010
+    ID_HELP_BUTTON = 1010,
+    ID_RECURSIVE_CHECKBOX = 1011
 };
 
 enum MenuId {
@@ -97,6 +101,7 @@ constexpr UINT_PTR TEXT_CONTEXT_SUBCLASS_ID = 1;
 constexpr UINT WM_APP_FOLDER_CONTENT_CHANGED = WM_APP + 1;
 constexpr UINT WM_APP_UPDATE_CHECK_COMPLETED = WM_APP + 2;
 constexpr UINT WM_APP_UPDATE_INSTALL_COMPLETED = WM_APP + 3;
+constexpr UINT WM_APP_PREVIEW_READY = WM_APP + 4;
 
 struct UpdateInstallResult {
     bool success;
@@ -197,6 +202,7 @@ Application::Application()
     , m_hReplacementEdit(nullptr)
     , m_hRegexCheckbox(nullptr)
     , m_hIgnoreCaseCheckbox(nullptr)
+    , m_hRecursiveCheckbox(nullptr)
     , m_hRenameButton(nullptr)
     , m_hHelpButton(nullptr)
     , m_hStatusLabel(nullptr)
@@ -215,6 +221,7 @@ Application::Application()
     , m_comInitialized(false)
     , m_useRegex(false)
     , m_ignoreCase(false)
+    , m_recursive(false)
     , m_infoWindowClassRegistered(false)
     , m_messageWindowClassRegistered(false)
     , m_updateBusy(false)
@@ -306,6 +313,11 @@ bool Application::Initialize(HINSTANCE hInstance) {
 
     SetTimer(m_hWnd, EXPLORER_SYNC_TIMER_ID, EXPLORER_SYNC_INTERVAL_MS, nullptr);
 
+    HWND previewWindow = m_hWnd;
+    m_previewService = std::make_unique<RenamerCore::PreviewService>([previewWindow]() {
+        PostMessageW(previewWindow, WM_APP_PREVIEW_READY, 0, 0);
+    });
+
     PrefillFolderFromExplorer();
     UpdatePreview();
     return true;
@@ -389,6 +401,7 @@ int Application::Run() {
 }
 
 void Application::Shutdown() {
+    m_previewService.reset();
     StopFolderWatcher();
 
     if (m_hWnd && IsWindow(m_hWnd)) {
@@ -463,6 +476,15 @@ LRESULT Application::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam) {
         }
         return 0;
 
+    case WM_APP_PREVIEW_READY:
+        {
+            RenamerCore::PreviewResult result;
+            if (m_previewService && m_previewService->TakeResult(result)) {
+                ShowPreviewResult(result.collect);
+            }
+        }
+        return 0;
+
     case WM_APP_UPDATE_CHECK_COMPLETED:
         {
             std::unique_ptr<UpdateCheckResult> result(reinterpret_cast<UpdateCheckResult*>(lParam));
@@ -489,6 +511,15 @@ LRESULT Application::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam) {
         }
         return 0;
 
+    case WM_NOTIFY:
+        {
+            const NMHDR* header = reinterpret_cast<const NMHDR*>(lParam);
+            if (header && IsPreviewList(header->hwndFrom)) {
+                return OnPreviewNotify(header);
+            }
+        }
+        break;
+
     case WM_MEASUREITEM:
         {
             MEASUREITEMSTRUCT* mis = reinterpret_cast<MEASUREITEMSTRUCT*>(lParam);
@@ -584,14 +615,19 @@ LRESULT Application::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam) {
                 break;
             }
 
-            if (dis->CtlID == ID_REGEX_CHECKBOX || dis->CtlID == ID_IGNORE_CASE_CHECKBOX) {
+            if (dis->CtlID == ID_REGEX_CHECKBOX || dis->CtlID == ID_IGNORE_CASE_CHECKBOX || dis->CtlID == ID_RECURSIVE_CHECKBOX) {
                 wchar_t text[256] = {};
                 GetWindowTextW(dis->hwndItem, text, 256);
                 const bool isPressed = m_pressedControl == dis->hwndItem || (dis->itemState & ODS_SELECTED) != 0;
                 const bool hasFocus = (dis->itemState & ODS_FOCUS) != 0;
                 const bool enabled = (dis->itemState & ODS_DISABLED) == 0;
                 const bool isHot = m_hoveredControl == dis->hwndItem;
-                const bool checked = (dis->CtlID == ID_REGEX_CHECKBOX) ? m_useRegex : m_ignoreCase;
+                bool checked = m_ignoreCase;
+                if (dis->CtlID == ID_REGEX_CHECKBOX) {
+                    checked = m_useRegex;
+                } else if (dis->CtlID == ID_RECURSIVE_CHECKBOX) {
+                    checked = m_recursive;
+                }
                 UiRenderer::DrawCustomCheckbox(dis->hDC, dis->hwndItem, text, checked, isHot, isPressed, enabled, hasFocus);
                 return TRUE;
             }
@@ -660,6 +696,8 @@ LRESULT Application::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam) {
                 m_pressedControl = m_hRegexCheckbox;
             } else if (IsPointInControl(m_hIgnoreCaseCheckbox, pt)) {
                 m_pressedControl = m_hIgnoreCaseCheckbox;
+            } else if (IsPointInControl(m_hRecursiveCheckbox, pt)) {
+                m_pressedControl = m_hRecursiveCheckbox;
             } else {
                 m_pressedControl = nullptr;
             }
@@ -913,6 +951,21 @@ void Application::CreateControls() {
         nullptr
     );
 
+    m_hRecursiveCheckbox = CreateWindowEx(
+        0,
+        L"BUTTON",
+        L"Включая подпапки",
+        WS_VISIBLE | WS_CHILD | WS_TABSTOP | BS_AUTOCHECKBOX | BS_OWNERDRAW,
+        0,
+        0,
+        0,
+        0,
+        m_hWnd,
+        reinterpret_cast<HMENU>(ID_RECURSIVE_CHECKBOX),
+        m_hInstance,
+        nullptr
+    );
+
     m_hRenameButton = CreateWindowEx(
         0,
         L"BUTTON",
@@ -990,9 +1043,9 @@ void Application::CreateControls() {
 
     m_hCurrentPreview = CreateWindowEx(
         0,
-        L"EDIT",
+        WC_LISTVIEW,
         L"",
-        WS_VISIBLE | WS_CHILD | WS_TABSTOP | ES_AUTOVSCROLL | ES_MULTILINE | ES_READONLY,
+        WS_VISIBLE | WS_CHILD | WS_TABSTOP | WS_VSCROLL | LVS_REPORT | LVS_OWNERDATA | LVS_NOCOLUMNHEADER | LVS_SINGLESEL | LVS_SHOWSELALWAYS,
         0,
         0,
         0,
@@ -1005,9 +1058,9 @@ void Application::CreateControls() {
 
     m_hResultPreview = CreateWindowEx(
         0,
-        L"EDIT",
+        WC_LISTVIEW,
         L"",
-        WS_VISIBLE | WS_CHILD | WS_TABSTOP | ES_AUTOVSCROLL | ES_MULTILINE | ES_READONLY,
+        WS_VISIBLE | WS_CHILD | WS_TABSTOP | WS_VSCROLL | LVS_REPORT | LVS_OWNERDATA | LVS_NOCOLUMNHEADER | LVS_SINGLESEL | LVS_SHOWSELALWAYS,
         0,
         0,
         0,
@@ -1018,6 +1071,9 @@ void Application::CreateControls() {
         nullptr
     );
 
+    InitializePreviewList(m_hCurrentPreview);
+    InitializePreviewList(m_hResultPreview);
+
     SetWindowSubclass(m_hFolderEdit, TextEditSubclassProc, TEXT_CONTEXT_SUBCLASS_ID, reinterpret_cast<DWORD_PTR>(this));
     SetWindowSubclass(m_hPatternEdit, TextEditSubclassProc, TEXT_CONTEXT_SUBCLASS_ID, reinterpret_cast<DWORD_PTR>(this));
     SetWindowSubclass(m_hReplacementEdit, TextEditSubclassProc, TEXT_CONTEXT_SUBCLASS_ID, reinterpret_cast<DWORD_PTR>(this));
@@ -1026,6 +1082,7 @@ void Application::CreateControls() {
 
     SendMessage(m_hRegexCheckbox, BM_SETCHECK, BST_UNCHECKED, 0);
     SendMessage(m_hIgnoreCaseCheckbox, BM_SETCHECK, BST_UNCHECKED, 0);
+    SendMessage(m_hRecursiveCheckbox, BM_SETCHECK, BST_UNCHECKED, 0);
 
     EnumChildWindows(
         m_hWnd,
@@ -1123,6 +1180,7 @@ void Application::OnResize(int width, int height) {
     const int actionRowY = rowTop + rowSpacing * 3;
     MoveWindow(m_hRegexCheckbox, controlLeft, actionRowY, 210, 26, TRUE);
     MoveWindow(m_hIgnoreCaseCheckbox, controlLeft + 216, actionRowY, 220, 26, TRUE);
+    MoveWindow(m_hRecursiveCheckbox, controlLeft, actionRowY + 34, 210, 26, TRUE);
     MoveWindow(m_hRenameButton, contentRight - 155, actionRowY - 1, 155, 30, TRUE);
     MoveWindow(m_hHelpButton, contentRight - 155, actionRowY + 34, 155, 28, TRUE);
 
@@ -1143,6 +1201,8 @@ void Application::OnResize(int width, int height) {
     const int previewHeight = std::max(120, previewCardBottom - cardPadding - previewTop);
     MoveWindow(m_hCurrentPreview, previewInnerLeft, previewTop, columnWidth, previewHeight, TRUE);
     MoveWindow(m_hResultPreview, rightColumnLeft, previewTop, columnWidth, previewHeight, TRUE);
+    ListView_SetColumnWidth(m_hCurrentPreview, 0, LVSCW_AUTOSIZE_USEHEADER);
+    ListView_SetColumnWidth(m_hResultPreview, 0, LVSCW_AUTOSIZE_USEHEADER);
 
     InvalidateRect(m_hWnd, nullptr, TRUE);
 }
@@ -1210,6 +1270,12 @@ void Application::OnCommand(UINT controlId, UINT notifyCode) {
         InvalidateRect(m_hIgnoreCaseCheckbox, nullptr, TRUE);
         UpdatePreview();
         break;
+    case ID_RECURSIVE_CHECKBOX:
+        m_recursive = !m_recursive;
+        SendMessage(m_hRecursiveCheckbox, BM_SETCHECK, m_recursive ? BST_CHECKED : BST_UNCHECKED, 0);
+        InvalidateRect(m_hRecursiveCheckbox, nullptr, TRUE);
+        UpdatePreview();
+        break;
 
     case ID_RENAME_BUTTON:
         RenameFiles();
@@ -1324,11 +1390,44 @@ void Application::ShowTextContextMenu(HWND targetControl, LPARAM lParam) {
     popupMenuInfo.hbrBack = m_hCardBrush;
     SetMenuInfo(contextMenu, &popupMenuInfo);
 
-    DWORD selectionStart = 0;
-    DWORD selectionEnd = 0;
-    SendMessageW(targetControl, EM_GETSEL, reinterpret_cast<WPARAM>(&selectionStart), reinterpret_cast<LPARAM>(&selectionEnd));
-    const bool hasSelection = selectionEnd > selectionStart;
-    const bool hasText = GetWindowTextLengthW(targetControl) > 0;
+    // Edits copy their selection or all of their text. Preview lists copy
+    // the selected row, since a list may hold millions of rows.
+    std::wstring textToCopy;
+    if (IsPreviewList(targetControl)) {
+        const int selectedRow = ListView_GetNextItem(targetControl, -1, LVNI_SELECTED);
+        if (selectedRow >= 0) {
+            textToCopy = GetPreviewRowText(static_cast<size_t>(selectedRow), targetControl == m_hResultPreview);
+        }
+    } else {
+        DWORD selectionStart = 0;
+        DWORD selectionEnd = 0;
+        SendMessageW(targetControl, EM_GETSEL, reinterpret_cast<WPARAM>(&selectionStart), reinterpret_cast<LPARAM>(&selectionEnd));
+        const bool hasSelection = selectionEnd > selectionStart;
+
+        const int textLength = GetWindowTextLengthW(targetControl);
+        if (textLength > 0) {
+            std::wstring controlText(static_cast<size_t>(textLength) + 1, L'\0');
+            GetWindowTextW(targetControl, controlText.data(), textLength + 1);
+            controlText.resize(static_cast<size_t>(textLength));
+
+            textToCopy = controlText;
+            if (hasSelection) {
+                size_t start = static_cast<size_t>(selectionStart);
+                size_t end = static_cast<size_t>(selectionEnd);
+                if (start > controlText.size()) {
+                    start = controlText.size();
+                }
+                if (end > controlText.size()) {
+                    end = controlText.size();
+                }
+                if (end < start) {
+                    end = start;
+                }
+                textToCopy = controlText.substr(start, end - start);
+            }
+        }
+    }
+    const bool hasText = !textToCopy.empty();
 
     EnableMenuItem(contextMenu, ID_MENU_CONTEXT_COPY, MF_BYCOMMAND | (hasText ? MF_ENABLED : MF_GRAYED));
 
@@ -1362,48 +1461,25 @@ void Application::ShowTextContextMenu(HWND targetControl, LPARAM lParam) {
     );
 
     if (selectedCommand == ID_MENU_CONTEXT_COPY && hasText) {
-        const int textLength = GetWindowTextLengthW(targetControl);
-        if (textLength > 0) {
-            std::wstring controlText(static_cast<size_t>(textLength) + 1, L'\0');
-            GetWindowTextW(targetControl, controlText.data(), textLength + 1);
-            controlText.resize(static_cast<size_t>(textLength));
-
-            std::wstring textToCopy = controlText;
-            if (hasSelection) {
-                size_t start = static_cast<size_t>(selectionStart);
-                size_t end = static_cast<size_t>(selectionEnd);
-                if (start > controlText.size()) {
-                    start = controlText.size();
-                }
-                if (end > controlText.size()) {
-                    end = controlText.size();
-                }
-                if (end < start) {
-                    end = start;
-                }
-                textToCopy = controlText.substr(start, end - start);
-            }
-
-            if (OpenClipboard(popupHostWindow)) {
-                EmptyClipboard();
-
-                const size_t bytes = (textToCopy.size() + 1) * sizeof(wchar_t);
-                HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, bytes);
-                if (memory) {
-                    void* memoryData = GlobalLock(memory);
-                    if (memoryData) {
-                        wcscpy_s(static_cast<wchar_t*>(memoryData), textToCopy.size() + 1, textToCopy.c_str());
-                        GlobalUnlock(memory);
-                        if (!SetClipboardData(CF_UNICODETEXT, memory)) {
-                            GlobalFree(memory);
-                        }
-                    } else {
+        if (OpenClipboard(popupHostWindow)) {
+            EmptyClipboard();
+
+            const size_t bytes = (textToCopy.size() + 1) * sizeof(wchar_t);
+            HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, bytes);
+            if (memory) {
+                void* memoryData = GlobalLock(memory);
+                if (memoryData) {
+                    wcscpy_s(static_cast<wchar_t*>(memoryData), textToCopy.size() + 1, textToCopy.c_str());
+                    GlobalUnlock(memory);
+                    if (!SetClipboardData(CF_UNICODETEXT, memory)) {
                         GlobalFree(memory);
                     }
+                } else {
+                    GlobalFree(memory);
                 }
-
-                CloseClipboard();
             }
+
+            CloseClipboard();
         }
     }
 
@@ -2142,53 +2218,104 @@ LRESULT CALLBACK Application::TextEditSubclassProc(HWND hWnd, UINT uMsg, WPARAM
 }
 
 void Application::UpdatePreview() {
-    const std::wstring folderText = Trim(GetEditText(m_hFolderEdit));
-    const std::wstring pattern = GetEditText(m_hPatternEdit);
-    const std::wstring replacement = GetEditText(m_hReplacementEdit);
-    UpdateFolderWatcher(folderText);
-    RenamerCore::CollectResult result = RenamerCore::CollectOperations(
-        folderText,
-        pattern,
-        replacement,
-        m_useRegex,
-        m_ignoreCase,
-        PREVIEW_LIMIT
-    );
-
-    if (result.operations.empty()) {
-        SetStatusText(result.status);
-        SetEditText(m_hCurrentPreview, L"");
-        SetEditText(m_hResultPreview, L"");
+    if (!m_previewService) {
         return;
     }
 
-    const size_t visibleCount = result.operations.size();
+    RenamerCore::PreviewRequest request;
+    request.folder = Trim(GetEditText(m_hFolderEdit));
+    request.pattern = GetEditText(m_hPatternEdit);
+    request.replacement = GetEditText(m_hReplacementEdit);
+    request.options = { m_useRegex, m_ignoreCase, m_recursive, PREVIEW_LIMIT, std::chrono::milliseconds(PREVIEW_REGEX_TIME_LIMIT_MS) };
+    request.options.estimateTimeLimit = std::chrono::milliseconds(PREVIEW_ESTIMATE_TIME_LIMIT_MS);
+    request.options.collectView = true;
+    UpdateFolderWatcher(request.folder);
+    TakePendingFolderChanges(request);
+    m_previewService->Request(std::move(request));
+}
+
+void Application::ShowPreviewResult(const RenamerCore::CollectResult& result) {
+    // The first rows of a view are the operations of the same result, so
+    // they serve as its first page.
+    m_previewView = result.view;
+    m_previewPage = result.operations;
+    m_previewPageOffset = 0;
+
+    const std::size_t rowCount = m_previewView ? m_previewView->size() : m_previewPage.size();
+    SetStatusText(result.status);
+    SetPreviewItemCount(m_hCurrentPreview, rowCount);
+    SetPreviewItemCount(m_hResultPreview, rowCount);
+}
+
+void Application::InitializePreviewList(HWND list) {
+    ListView_SetExtendedListViewStyle(list, LVS_EX_DOUBLEBUFFER | LVS_EX_FULLROWSELECT);
+    ListView_SetBkColor(list, RGB(45, 45, 45));
+    ListView_SetTextBkColor(list, RGB(45, 45, 45));
+    ListView_SetTextColor(list, RGB(243, 244, 246));
+
+    LVCOLUMNW column = {};
+    column.mask = LVCF_WIDTH;
+    column.cx = 100;
+    ListView_InsertColumn(list, 0, &column);
+}
+
+void Application::SetPreviewItemCount(HWND list, std::size_t count) {
+    const std::size_t maxCount = static_cast<std::size_t>((std::numeric_limits<int>::max)());
+    ListView_SetItemCountEx(list, static_cast<int>((std::min)(count, maxCount)), LVSICF_NOSCROLL);
+    InvalidateRect(list, nullptr, FALSE);
+}
+
+LRESULT Application::OnPreviewNotify(const NMHDR* header) {
+    switch (header->code) {
+    case LVN_GETDISPINFOW:
+        {
+            const LVITEMW& item = reinterpret_cast<const NMLVDISPINFOW*>(header)->item;
+            if ((item.mask & LVIF_TEXT) && item.pszText && item.cchTextMax > 0) {
+                const std::wstring text = GetPreviewRowText(static_cast<std::size_t>(item.iItem), header->hwndFrom == m_hResultPreview);
+                wcsncpy_s(item.pszText, static_cast<size_t>(item.cchTextMax), text.c_str(), _TRUNCATE);
+            }
+        }
+        return 0;
+
+    case LVN_ODCACHEHINT:
+        {
+            const NMLVCACHEHINT* hint = reinterpret_cast<const NMLVCACHEHINT*>(header);
+            if (hint->iFrom >= 0 && hint->iTo >= hint->iFrom) {
+                LoadPreviewPage(static_cast<std::size_t>(hint->iFrom), static_cast<std::size_t>(hint->iTo - hint->iFrom) + 1);
+            }
+        }
+        return 0;
+    }
 
-    std::vector<std::wstring> currentNames;
-    std::vector<std::wstring> newNames;
-    currentNames.reserve(visibleCount + 1);
-    newNames.reserve(visibleCount + 1);
+    return 0;
+}
 
-    for (size_t index = 0; index < visibleCount; ++index) {
-        const auto& operation = result.operations[index];
-        const std::wstring directorySuffix = operation.isDirectory ? L"\\" : L"";
-        currentNames.push_back(operation.oldName + directorySuffix);
-        newNames.push_back(operation.newName + directorySuffix);
+void Application::LoadPreviewPage(std::size_t offset, std::size_t count) {
+    if (!m_previewView) {
+        return;
+    }
+    if (offset >= m_previewPageOffset && offset + count <= m_previewPageOffset + m_previewPage.size()) {
+        return;
     }
 
-    std::wstring status = result.status;
-    const size_t hiddenCount = result.totalCount > visibleCount ? (result.totalCount - visibleCount) : 0;
-    if (hiddenCount > 0) {
-        const std::wstring suffix = L"... и еще " + std::to_wstring(hiddenCount) + L" элементов";
-        currentNames.push_back(suffix);
-        newNames.push_back(suffix);
-        status += L". Показано: " + std::to_wstring(visibleCount)
-            + L" (лимит " + std::to_wstring(PREVIEW_LIMIT) + L").";
+    m_previewPage = m_previewView->GetRange(offset, std::max(count, PREVIEW_PAGE_SIZE));
+    m_previewPageOffset = offset;
+}
+
+std::wstring Application::GetPreviewRowText(std::size_t index, bool newName) {
+    if (index < m_previewPageOffset || index - m_previewPageOffset >= m_previewPage.size()) {
+        LoadPreviewPage(index - index % PREVIEW_PAGE_SIZE, PREVIEW_PAGE_SIZE);
+    }
+    if (index < m_previewPageOffset || index - m_previewPageOffset >= m_previewPage.size()) {
+        return L"";
     }
 
-    SetStatusText(status);
-    SetEditText(m_hCurrentPreview, JoinLines(currentNames));
-    SetEditText(m_hResultPreview, JoinLines(newNames));
+    const std::size_t row = index - m_previewPageOffset;
+    std::wstring text = newName ? m_previewPage.GetNewDisplayName(row) : m_previewPage.GetOldDisplayName(row);
+    if (m_previewPage.IsDirectory(row)) {
+        text += L"\\";
+    }
+    return text;
 }
 
 void Application::RenameFiles() {
@@ -2199,8 +2326,7 @@ void Application::RenameFiles() {
         folderText,
         pattern,
         replacement,
-        m_useRegex,
-        m_ignoreCase
+        { m_useRegex, m_ignoreCase, m_recursive, 0 }
     );
 
     if (collectResult.operations.empty()) {
@@ -2358,6 +2484,12 @@ void Application::StopFolderWatcher() {
         m_folderWatchThread.join();
     }
 
+    {
+        std::lock_guard<std::mutex> lock(m_folderChangesMutex);
+        m_pendingFolderChanges.clear();
+        m_folderRescanRequired = false;
+    }
+
     if (m_folderWatchDirectoryHandle != INVALID_HANDLE_VALUE) {
         CloseHandle(m_folderWatchDirectoryHandle);
         m_folderWatchDirectoryHandle = INVALID_HANDLE_VALUE;
@@ -2424,15 +2556,20 @@ void Application::FolderWatcherThreadProc(HANDLE directoryHandle, HANDLE stopEve
                 break;
             }
             if (resultError == ERROR_NOTIFY_ENUM_DIR) {
+                QueueFolderChanges({}, true);
                 PostFolderWatcherRefresh();
                 continue;
             }
             break;
         }
 
-        if (bytesTransferred > 0) {
-            PostFolderWatcherRefresh();
-        }
+        // Zero bytes on success means the system buffer overflowed and the
+        // records were dropped.
+        std::vector<RenamerCore::FolderChange> changes;
+        const bool complete = bytesTransferred > 0
+            && RenamerCore::Platform::ParseFolderChanges(buffer.data(), bytesTransferred, changes);
+        QueueFolderChanges(std::move(changes), !complete);
+        PostFolderWatcherRefresh();
     }
 
     CloseHandle(ioEvent);
@@ -2454,6 +2591,31 @@ void Application::PostFolderWatcherRefresh() {
     }
 }
 
+void Application::QueueFolderChanges(std::vector<RenamerCore::FolderChange>&& changes, bool rescanRequired) {
+    std::lock_guard<std::mutex> lock(m_folderChangesMutex);
+    if (rescanRequired) {
+        m_folderRescanRequired = true;
+    }
+
+    if (m_folderRescanRequired) {
+        m_pendingFolderChanges.clear();
+        return;
+    }
+
+    m_pendingFolderChanges.insert(
+        m_pendingFolderChanges.end(),
+        std::make_move_iterator(changes.begin()),
+        std::make_move_iterator(changes.end())
+    );
+}
+
+void Application::TakePendingFolderChanges(RenamerCore::PreviewRequest& request) {
+    std::lock_guard<std::mutex> lock(m_folderChangesMutex);
+    request.folderChanges.swap(m_pendingFolderChanges);
+    request.rescanRequired = m_folderRescanRequired;
+    m_folderRescanRequired = false;
+}
+
 std::wstring Application::GetEditText(HWND control) const {
     if (!control) {
         return L"";
@@ -2485,7 +2647,7 @@ void Application::SetStatusText(const std::wstring& text) {
 bool Application::HandlePreviewMouseWheel(WPARAM wParam, LPARAM lParam) {
     POINT screenPoint = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
     const HWND hoveredWindow = WindowFromPoint(screenPoint);
-    if (hoveredWindow != m_hCurrentPreview && hoveredWindow != m_hResultPreview) {
+    if (!IsPreviewList(hoveredWindow)) {
         return false;
     }
 
@@ -2506,19 +2668,26 @@ bool Application::HandlePreviewMouseWheel(WPARAM wParam, LPARAM lParam) {
     if (linesPerNotch == WHEEL_PAGESCROLL) {
         const WPARAM scrollCommand = (direction < 0) ? SB_PAGEUP : SB_PAGEDOWN;
         for (int index = 0; index < notchCount; ++index) {
-            SendMessageW(hoveredWindow, EM_SCROLL, scrollCommand, 0);
+            SendMessageW(hoveredWindow, WM_VSCROLL, MAKEWPARAM(scrollCommand, 0), 0);
         }
         return true;
     }
 
     if (linesPerNotch > 0) {
-        const int totalLines = static_cast<int>(linesPerNotch) * notchCount * direction;
-        SendMessageW(hoveredWindow, EM_LINESCROLL, 0, totalLines);
+        const WPARAM scrollCommand = (direction < 0) ? SB_LINEUP : SB_LINEDOWN;
+        const int totalLines = static_cast<int>(linesPerNotch) * notchCount;
+        for (int index = 0; index < totalLines; ++index) {
+            SendMessageW(hoveredWindow, WM_VSCROLL, MAKEWPARAM(scrollCommand, 0), 0);
+        }
     }
 
     return true;
 }
 
+bool Application::IsPreviewList(HWND control) const {
+    return control && (control == m_hCurrentPreview || control == m_hResultPreview);
+}
+
 void Application::UpdateHoverState(POINT clientPoint) {
     HWND hovered = nullptr;
 
@@ -2532,6 +2701,8 @@ void Application::UpdateHoverState(POINT clientPoint) {
         hovered = m_hRegexCheckbox;
     } else if (IsPointInControl(m_hIgnoreCaseCheckbox, clientPoint)) {
         hovered = m_hIgnoreCaseCheckbox;
+    } else if (IsPointInControl(m_hRecursiveCheckbox, clientPoint)) {
+        hovered = m_hRecursiveCheckbox;
     }
 
     if (hovered == m_hoveredControl) {
@@ -2564,19 +2735,3 @@ bool Application::IsPointInControl(HWND control, POINT clientPoint) const {
     ScreenToClient(m_hWnd, reinterpret_cast<LPPOINT>(&rect.right));
     return PtInRect(&rect, clientPoint) != FALSE;
 }
-
-std::wstring Application::JoinLines(const std::vector<std::wstring>& lines) {
-    if (lines.empty()) {
-        return L"";
-    }
-
-    std::wstring result;
-    for (size_t index = 0; index < lines.size(); ++index) {
-        result += lines[index];
-        if (index + 1 < lines.size()) {
-            result += L"\r\n";
-        }
-    }
-
-    return result;
-}
@@ -6,11 +6,13 @@
 
 #include <windows.h>
 
+#include "PreviewService.h"
 #include "RenamerService.h"
 
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -49,6 +51,12 @@ private:
     void OnMenuCommand(UINT menuId);
 
     void UpdatePreview();
+    void ShowPreviewResult(const RenamerCore::CollectResult& result);
+    void InitializePreviewList(HWND list);
+    void SetPreviewItemCount(HWND list, std::size_t count);
+    LRESULT OnPreviewNotify(const NMHDR* header);
+    void LoadPreviewPage(std::size_t offset, std::size_t count);
+    std::wstring GetPreviewRowText(std::size_t index, bool newName);
     void RenameFiles();
 
     void SelectFolder();
@@ -60,6 +68,8 @@ private:
     void StopFolderWatcher();
     void FolderWatcherThreadProc(HANDLE directoryHandle, HANDLE stopEvent);
     void PostFolderWatcherRefresh();
+    void QueueFolderChanges(std::vector<RenamerCore::FolderChange>&& changes, bool rescanRequired);
+    void TakePendingFolderChanges(RenamerCore::PreviewRequest& request);
 
     bool RegisterInfoWindowClass();
     bool RegisterMessageWindowClass();
@@ -86,12 +96,11 @@ private:
     void SetEditText(HWND control, const std::wstring& text);
     void SetStatusText(const std::wstring& text);
     bool HandlePreviewMouseWheel(WPARAM wParam, LPARAM lParam);
+    bool IsPreviewList(HWND control) const;
 
     void UpdateHoverState(POINT clientPoint);
     bool IsPointInControl(HWND control, POINT clientPoint) const;
 
-    static std::wstring JoinLines(const std::vector<std::wstring>& lines);
-
     HINSTANCE m_hInstance;
     HWND m_hWnd;
 
@@ -107,6 +116,7 @@ private:
 
     HWND m_hRegexCheckbox;
     HWND m_hIgnoreCaseCheckbox;
+    HWND m_hRecursiveCheckbox;
     HWND m_hRenameButton;
     HWND m_hHelpButton;
 
@@ -130,6 +140,7 @@ private:
     bool m_comInitialized;
     bool m_useRegex;
     bool m_ignoreCase;
+    bool m_recursive;
     bool m_infoWindowClassRegistered;
     bool m_messageWindowClassRegistered;
     bool m_updateBusy;
@@ -139,14 +150,28 @@ private:
     std::map<HWND, float> m_buttonHoverAlpha;
     std::unique_ptr<ToolTip> m_tooltil;
 
+    std::unique_ptr<RenamerCore::PreviewService> m_previewService;
+    // Rows of the preview lists: every match of the last complete preview,
+    // with a page of them materialized in m_previewPage starting at
+    // m_previewPageOffset. Streamed partial results only fill the page.
+    std::shared_ptr<RenamerCore::PlanView> m_previewView;
+    RenamerCore::RenamePlan m_previewPage;
+    std::size_t m_previewPageOffset = 0;
+
     std::wstring m_lastExplorerFolder;
     std::wstring m_watchedFolderKey;
     HANDLE m_folderWatchDirectoryHandle = INVALID_HANDLE_VALUE;
     HANDLE m_folderWatchStopEvent = nullptr;
     std::thread m_folderWatchThread;
     std::atomic_bool m_folderWatchRefreshPosted { false };
+    std::mutex m_folderChangesMutex;
+    std::vector<RenamerCore::FolderChange> m_pendingFolderChanges;
+    bool m_folderRescanRequired = false;
 
     static constexpr int PREVIEW_LIMIT = 400;
+    static constexpr std::size_t PREVIEW_PAGE_SIZE = 256;
+    static constexpr int PREVIEW_REGEX_TIME_LIMIT_MS = 1500;
+    static constexpr int PREVIEW_ESTIMATE_TIME_LIMIT_MS = 20;
     static constexpr UINT_PTR EXPLORER_SYNC_TIMER_ID = 1;
     static constexpr UINT_PTR FOLDER_WATCH_DEBOUNCE_TIMER_ID = 2;
     static constexpr UINT EXPLORER_SYNC_INTERVAL_MS = 300;
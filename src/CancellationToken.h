@@ -0,0 +1,19 @@
+#pragma once
+
+#include <atomic>
+
+namespace RenamerCore {
+
+// Cooperative cancellation: the requester calls Cancel(), long-running work
+// polls IsCancelled() at points where it can stop cleanly.
+class CancellationToken {
+public:
+    void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    void Reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+    bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> m_cancelled { false };
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,112 @@
+#include "CaseFolding.h"
+
+#include <algorithm>
+
+namespace {
+
+bool InRange(wchar_t ch, unsigned first, unsigned last) {
+    const unsigned code = static_cast<unsigned>(ch);
+    return code >= first && code <= last;
+}
+
+wchar_t Shift(wchar_t ch, int delta) {
+    return static_cast<wchar_t>(static_cast<int>(ch) + delta);
+}
+
+bool IsEven(wchar_t ch) {
+    return (static_cast<unsigned>(ch) & 1U) == 0;
+}
+
+} // namespace
+
+namespace RenamerCore {
+
+wchar_t SimpleToLower(wchar_t ch) {
+    const unsigned code = static_cast<unsigned>(ch);
+    if (code < 0x80) {
+        return (code >= L'A' && code <= L'Z') ? Shift(ch, 32) : ch;
+    }
+
+    if (InRange(ch, 0x00C0, 0x00DE)) {
+        return code == 0x00D7 ? ch : Shift(ch, 32);
+    }
+
+    if (InRange(ch, 0x0100, 0x017F)) {
+        if (code == 0x0130) {
+            return L'i';
+        }
+        if (code == 0x0178) {
+            return static_cast<wchar_t>(0x00FF);
+        }
+        if (InRange(ch, 0x0139, 0x0148) || InRange(ch, 0x0179, 0x017E)) {
+            return IsEven(ch) ? ch : Shift(ch, 1);
+        }
+        if (code == 0x0131 || code == 0x0138 || code == 0x0149 || code == 0x017F) {
+            return ch;
+        }
+        return IsEven(ch) ? Shift(ch, 1) : ch;
+    }
+
+    if (InRange(ch, 0x0386, 0x03AB)) {
+        if (code == 0x0386) {
+            return static_cast<wchar_t>(0x03AC);
+        }
+        if (InRange(ch, 0x0388, 0x038A)) {
+            return Shift(ch, 37);
+        }
+        if (code == 0x038C) {
+            return static_cast<wchar_t>(0x03CC);
+        }
+        if (code == 0x038E || code == 0x038F) {
+            return Shift(ch, 63);
+        }
+        if (InRange(ch, 0x0391, 0x03AB) && code != 0x03A2) {
+            return Shift(ch, 32);
+        }
+        return ch;
+    }
+
+    if (InRange(ch, 0x0400, 0x052F)) {
+        if (code <= 0x040F) {
+            return Shift(ch, 80);
+        }
+        if (code <= 0x042F) {
+            return Shift(ch, 32);
+        }
+        if (code <= 0x045F) {
+            return ch;
+        }
+        if (code == 0x04C0) {
+            return static_cast<wchar_t>(0x04CF);
+        }
+        if (InRange(ch, 0x04C1, 0x04CE)) {
+            return IsEven(ch) ? ch : Shift(ch, 1);
+        }
+        if (InRange(ch, 0x0482, 0x0489) || code == 0x04CF) {
+            return ch;
+        }
+        return IsEven(ch) ? Shift(ch, 1) : ch;
+    }
+
+    if (InRange(ch, 0x0531, 0x0556)) {
+        return Shift(ch, 48);
+    }
+
+    if (InRange(ch, 0x1E00, 0x1E95) || InRange(ch, 0x1EA0, 0x1EFF)) {
+        return IsEven(ch) ? Shift(ch, 1) : ch;
+    }
+
+    if (InRange(ch, 0xFF21, 0xFF3A)) {
+        return Shift(ch, 32);
+    }
+
+    return ch;
+}
+
+std::wstring SimpleToLowerCopy(const std::wstring& text) {
+    std::wstring lowered = text;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), SimpleToLower);
+    return lowered;
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+namespace RenamerCore {
+
+// Locale-independent simple lowercase mapping (one code unit in, one out).
+// Covers Latin, Greek, Cyrillic, Armenian and fullwidth Latin letters.
+wchar_t SimpleToLower(wchar_t ch);
+std::wstring SimpleToLowerCopy(const std::wstring& text);
+
+} // namespace RenamerCore
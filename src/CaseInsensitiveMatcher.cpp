@@ -0,0 +1,59 @@
+#include "CaseInsensitiveMatcher.h"
+
+#include "Platform.h"
+
+namespace RenamerCore {
+
+CaseInsensitiveMatcher::CaseInsensitiveMatcher(std::wstring_view pattern)
+    : m_lowerTable(Platform::GetLowerCaseTable())
+    , m_foldedPattern(pattern) {
+    for (wchar_t& ch : m_foldedPattern) {
+        ch = Fold(ch);
+    }
+}
+
+std::size_t CaseInsensitiveMatcher::Find(std::wstring_view text, std::size_t start) const {
+    const std::size_t patternSize = m_foldedPattern.size();
+    if (patternSize == 0 || start >= text.size() || text.size() - start < patternSize) {
+        return std::wstring_view::npos;
+    }
+
+    const wchar_t first = m_foldedPattern[0];
+    const std::size_t last = text.size() - patternSize;
+    for (std::size_t position = start; position <= last; ++position) {
+        if (Fold(text[position]) != first) {
+            continue;
+        }
+
+        std::size_t matched = 1;
+        while (matched < patternSize && Fold(text[position + matched]) == m_foldedPattern[matched]) {
+            ++matched;
+        }
+        if (matched == patternSize) {
+            return position;
+        }
+    }
+
+    return std::wstring_view::npos;
+}
+
+bool CaseInsensitiveMatcher::ReplaceAll(std::wstring_view text, std::wstring_view replacement, std::wstring& output) const {
+    std::size_t foundPos = Find(text);
+    if (foundPos == std::wstring_view::npos) {
+        return false;
+    }
+
+    output.clear();
+    std::size_t sourcePos = 0;
+    do {
+        output.append(text, sourcePos, foundPos - sourcePos);
+        output.append(replacement);
+        sourcePos = foundPos + m_foldedPattern.size();
+        foundPos = Find(text, sourcePos);
+    } while (foundPos != std::wstring_view::npos);
+
+    output.append(text, sourcePos, std::wstring_view::npos);
+    return true;
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace RenamerCore {
+
+// Case-insensitive literal search with the pattern folded once up front.
+// Names are folded one code unit at a time while they are scanned, so a
+// search allocates nothing. Folding follows Platform::ToLower per character.
+class CaseInsensitiveMatcher {
+public:
+    explicit CaseInsensitiveMatcher(std::wstring_view pattern);
+
+    // Position of the first match at or after `start`, or npos.
+    std::size_t Find(std::wstring_view text, std::size_t start = 0) const;
+
+    // Replaces every non-overlapping match in a single scan. Returns false,
+    // leaving `output` untouched, when the text does not match at all.
+    bool ReplaceAll(std::wstring_view text, std::wstring_view replacement, std::wstring& output) const;
+
+private:
+    wchar_t Fold(wchar_t ch) const {
+        const auto code = static_cast<std::make_unsigned_t<wchar_t>>(ch);
+        if constexpr (sizeof(wchar_t) == 2) {
+            return m_lowerTable[code];
+        } else {
+            return code < 0x10000 ? m_lowerTable[code] : ch;
+        }
+    }
+
+    const wchar_t* m_lowerTable;
+    std::wstring m_foldedPattern;
+};
+
+} // namespace RenamerCore
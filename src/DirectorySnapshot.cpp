@@ -0,0 +1,197 @@
+#include "DirectorySnapshot.h"
+
+#include "NaturalSortKey.h"
+#include "ParallelSort.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+std::int64_t NowUnixNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+// A listing taken while the folder mtime is still within one timestamp tick
+// may miss a change that lands in the same tick, so such a snapshot is
+// re-enumerated on the next refresh. Whole-second mtimes suggest a coarse
+// filesystem (FAT keeps 2 s); otherwise the kernel clock tick dominates.
+constexpr std::int64_t kCoarseRacyWindowNs = 2LL * 1000 * 1000 * 1000;
+constexpr std::int64_t kFineRacyWindowNs = 50LL * 1000 * 1000;
+
+bool IsStampSettled(const RenamerCore::Platform::DirectoryStamp& stamp) {
+    const bool coarse = stamp.modifiedTime % (1000LL * 1000 * 1000) == 0;
+    const std::int64_t window = coarse ? kCoarseRacyWindowNs : kFineRacyWindowNs;
+    return NowUnixNanoseconds() - stamp.modifiedTime > window;
+}
+
+// Below this many net changes entries are inserted/erased one by one;
+// larger batches are merged in a single pass over the listing.
+constexpr std::size_t kBatchMergeThreshold = 16;
+
+// Patched listings leave removed names behind in the arena; it is compacted
+// once the dead text outgrows the live names.
+constexpr std::size_t kArenaGarbageFactor = 2;
+
+} // namespace
+
+namespace RenamerCore {
+
+SnapshotStatus DirectorySnapshot::Refresh(const fs::path& folder, const CancellationToken* cancellation) {
+    Platform::DirectoryStamp stamp;
+    if (!Platform::GetDirectoryStamp(folder, stamp)) {
+        Invalidate();
+        return SnapshotStatus::NotFound;
+    }
+
+    const std::wstring folderKey = Platform::PathKey(folder);
+    if (CanReuse(folderKey, stamp)) {
+        return SnapshotStatus::Reused;
+    }
+
+    Invalidate();
+
+    const Clock::time_point enumerateStart = Clock::now();
+    std::vector<DirectoryEntry> entries;
+    EntryArena& arena = m_arena;
+    const bool enumerated = Platform::EnumerateDirectory(folder, [&entries, &arena, cancellation](std::wstring_view name, bool isDirectory) {
+        entries.push_back(arena.AddName(name, isDirectory));
+        return !cancellation || !cancellation->IsCancelled();
+    });
+    if (cancellation && cancellation->IsCancelled()) {
+        m_arena.Clear();
+        return SnapshotStatus::Cancelled;
+    }
+    if (!enumerated) {
+        m_arena.Clear();
+        return SnapshotStatus::ReadError;
+    }
+
+    const Clock::time_point sortStart = Clock::now();
+    ThreadPool& pool = ThreadPool::Shared();
+    const bool parallel = m_parallelSortThreshold > 0
+        && entries.size() >= m_parallelSortThreshold
+        && pool.GetThreadCount() > 1;
+    m_arena.BuildSortKeys(entries, pool, parallel);
+    auto entryLess = [&arena](const DirectoryEntry& left, const DirectoryEntry& right) {
+        return arena.Less(left, right);
+    };
+    if (parallel) {
+        ParallelSort(entries, entryLess, pool);
+    } else {
+        std::sort(entries.begin(), entries.end(), entryLess);
+    }
+    m_arena.Compact(entries);
+
+    m_enumerateTime = sortStart - enumerateStart;
+    m_sortTime = Clock::now() - sortStart;
+    m_folder = folder;
+    m_folderKey = folderKey;
+    m_stamp = stamp;
+    m_entries = std::move(entries);
+    m_stampTrusted = IsStampSettled(stamp);
+    m_valid = true;
+    return SnapshotStatus::Loaded;
+}
+
+void DirectorySnapshot::Invalidate() {
+    m_valid = false;
+    m_stampTrusted = false;
+    m_entries.clear();
+    m_arena.Clear();
+    m_enumerateTime = std::chrono::nanoseconds(0);
+    m_sortTime = std::chrono::nanoseconds(0);
+}
+
+bool DirectorySnapshot::ApplyChanges(const std::vector<FolderChange>& changes) {
+    if (!m_valid) {
+        return false;
+    }
+
+    // Collapse the batch to the final state of every touched name.
+    std::map<std::wstring, FolderChangeAction, std::less<>> finalActions;
+    for (const FolderChange& change : changes) {
+        finalActions[change.name] = change.action;
+    }
+
+    std::vector<DirectoryEntry> added;
+    for (const auto& [name, action] : finalActions) {
+        if (action != FolderChangeAction::Added) {
+            continue;
+        }
+
+        const Platform::EntryType type = Platform::GetEntryType(m_folder / Platform::ToPath(name));
+        if (type != Platform::EntryType::Other) {
+            added.push_back(m_arena.Add(name, type == Platform::EntryType::Directory));
+        }
+    }
+
+    const EntryArena& arena = m_arena;
+    auto entryLess = [&arena](const DirectoryEntry& left, const DirectoryEntry& right) {
+        return arena.Less(left, right);
+    };
+    std::sort(added.begin(), added.end(), entryLess);
+
+    if (finalActions.size() <= kBatchMergeThreshold) {
+        for (const auto& touched : finalActions) {
+            const std::wstring& name = touched.first;
+            const std::string key = MakeNaturalSortKey(name);
+            const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, [&arena, &name](const DirectoryEntry& entry, const std::string& value) {
+                const int compareResult = arena.GetSortKey(entry).compare(value);
+                if (compareResult != 0) {
+                    return compareResult < 0;
+                }
+                return arena.GetName(entry) < name;
+            });
+            if (it != m_entries.end() && arena.GetName(*it) == name) {
+                m_entries.erase(it);
+            }
+        }
+        for (const DirectoryEntry& entry : added) {
+            const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry, entryLess);
+            m_entries.insert(it, entry);
+        }
+    } else {
+        m_entries.erase(
+            std::remove_if(m_entries.begin(), m_entries.end(), [&arena, &finalActions](const DirectoryEntry& entry) {
+                return finalActions.find(arena.GetName(entry)) != finalActions.end();
+            }),
+            m_entries.end()
+        );
+
+        std::vector<DirectoryEntry> merged;
+        merged.reserve(m_entries.size() + added.size());
+        std::merge(m_entries.begin(), m_entries.end(), added.begin(), added.end(), std::back_inserter(merged), entryLess);
+        m_entries = std::move(merged);
+    }
+
+    std::size_t liveNameSize = 0;
+    for (const DirectoryEntry& entry : m_entries) {
+        liveNameSize += entry.NameLength();
+    }
+    if (m_arena.GetNameBufferSize() > kArenaGarbageFactor * liveNameSize) {
+        m_arena.Compact(m_entries);
+    }
+
+    Platform::DirectoryStamp stamp;
+    if (!Platform::GetDirectoryStamp(m_folder, stamp)) {
+        Invalidate();
+        return false;
+    }
+
+    m_stamp = stamp;
+    m_stampTrusted = true;
+    return true;
+}
+
+bool DirectorySnapshot::CanReuse(const std::wstring& folderKey, const Platform::DirectoryStamp& stamp) const {
+    return m_valid && m_stampTrusted && folderKey == m_folderKey && stamp == m_stamp;
+}
+
+} // namespace RenamerCore
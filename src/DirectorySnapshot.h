@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "EntryArena.h"
+#include "FolderChanges.h"
+#include "Platform.h"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace RenamerCore {
+
+enum class SnapshotStatus {
+    Reused,
+    Loaded,
+    NotFound,
+    ReadError,
+    Cancelled
+};
+
+// Enumerated, natural-sorted listing of a single folder. Refresh() keeps the
+// previous listing while the folder stamp is unchanged, so repeated previews
+// of the same folder only pay for the match/replace pass.
+class DirectorySnapshot {
+public:
+    static constexpr std::size_t DEFAULT_PARALLEL_SORT_THRESHOLD = 50000;
+
+    // A cancelled refresh leaves the snapshot invalid.
+    SnapshotStatus Refresh(const std::filesystem::path& folder, const CancellationToken* cancellation = nullptr);
+    void Invalidate();
+
+    // Patches the sorted listing with watcher deltas instead of re-enumerating.
+    // Only valid while a watcher covers the folder: the stamp is re-read and
+    // trusted afterwards, because any later change will arrive as another
+    // delta. Returns false if there is no listing to patch.
+    bool ApplyChanges(const std::vector<FolderChange>& changes);
+
+    // Listings with at least this many entries are key-built and sorted on
+    // the shared thread pool; 0 disables the parallel path.
+    void SetParallelSortThreshold(std::size_t threshold) { m_parallelSortThreshold = threshold; }
+
+    bool IsValid() const { return m_valid; }
+    const std::filesystem::path& GetFolder() const { return m_folder; }
+    const std::vector<DirectoryEntry>& GetEntries() const { return m_entries; }
+    const EntryArena& GetArena() const { return m_arena; }
+    std::chrono::nanoseconds GetEnumerateTime() const { return m_enumerateTime; }
+    std::chrono::nanoseconds GetSortTime() const { return m_sortTime; }
+
+private:
+    bool CanReuse(const std::wstring& folderKey, const Platform::DirectoryStamp& stamp) const;
+
+    std::filesystem::path m_folder;
+    std::wstring m_folderKey;
+    Platform::DirectoryStamp m_stamp;
+    std::vector<DirectoryEntry> m_entries;
+    EntryArena m_arena;
+    std::chrono::nanoseconds m_enumerateTime { 0 };
+    std::chrono::nanoseconds m_sortTime { 0 };
+    std::size_t m_parallelSortThreshold = DEFAULT_PARALLEL_SORT_THRESHOLD;
+    bool m_valid = false;
+    bool m_stampTrusted = false;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,115 @@
+#include "DirectoryTree.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace fs = std::filesystem;
+namespace Platform = RenamerCore::Platform;
+
+namespace {
+
+struct FolderNode {
+    fs::path path;
+    std::wstring relativePath;
+    std::vector<RenamerCore::DirectoryEntry> entries;
+    RenamerCore::EntryArena arena;
+    // Parallel to `entries`; null for files and for folders not descended into.
+    std::vector<std::unique_ptr<FolderNode>> children;
+    bool readable = false;
+};
+
+std::wstring JoinRelative(const std::wstring& parent, const std::wstring& name) {
+    if (parent.empty()) {
+        return name;
+    }
+    return parent + static_cast<wchar_t>(fs::path::preferred_separator) + name;
+}
+
+bool IsRealDirectory(const fs::path& path) {
+    std::error_code statusEc;
+    const fs::file_status status = fs::symlink_status(path, statusEc);
+    return !statusEc && fs::is_directory(status);
+}
+
+void ScanFolder(FolderNode& node, RenamerCore::TaskGroup& group, const RenamerCore::CancellationToken* cancellation) {
+    node.readable = Platform::EnumerateDirectory(node.path, [&node, cancellation](std::wstring_view name, bool isDirectory) {
+        node.entries.push_back(node.arena.Add(name, isDirectory));
+        return !cancellation || !cancellation->IsCancelled();
+    });
+    if (!node.readable) {
+        node.entries.clear();
+        node.arena.Clear();
+        return;
+    }
+
+    const RenamerCore::EntryArena& arena = node.arena;
+    std::sort(node.entries.begin(), node.entries.end(), [&arena](const RenamerCore::DirectoryEntry& left, const RenamerCore::DirectoryEntry& right) {
+        return arena.Less(left, right);
+    });
+    node.children.resize(node.entries.size());
+
+    for (std::size_t index = 0; index < node.entries.size(); ++index) {
+        const RenamerCore::DirectoryEntry& entry = node.entries[index];
+        if (!entry.IsDirectory()) {
+            continue;
+        }
+
+        const std::wstring name(arena.GetName(entry));
+        fs::path childPath = node.path / Platform::ToPath(name);
+        if (!IsRealDirectory(childPath)) {
+            continue;
+        }
+
+        auto child = std::make_unique<FolderNode>();
+        child->path = std::move(childPath);
+        child->relativePath = JoinRelative(node.relativePath, name);
+        FolderNode* childNode = child.get();
+        node.children[index] = std::move(child);
+
+        group.Run([childNode, &group, cancellation]() {
+            ScanFolder(*childNode, group, cancellation);
+        });
+    }
+}
+
+void Flatten(FolderNode& node, RenamerCore::DirectoryTree& tree) {
+    const std::size_t directoryIndex = tree.directories.size();
+    tree.directories.push_back(std::move(node.relativePath));
+    if (!node.readable) {
+        ++tree.unreadableCount;
+        return;
+    }
+
+    for (std::size_t index = 0; index < node.entries.size(); ++index) {
+        const RenamerCore::DirectoryEntry& entry = node.entries[index];
+        tree.entries.push_back({ directoryIndex, tree.arena.AddName(node.arena.GetName(entry), entry.IsDirectory()) });
+        if (node.children[index]) {
+            Flatten(*node.children[index], tree);
+        }
+    }
+}
+
+} // namespace
+
+namespace RenamerCore {
+
+bool ScanDirectoryTree(const fs::path& root, ThreadPool& pool, DirectoryTree& tree, const CancellationToken* cancellation) {
+    tree = DirectoryTree();
+
+    FolderNode rootNode;
+    rootNode.path = root;
+    {
+        TaskGroup group(pool);
+        ScanFolder(rootNode, group, cancellation);
+        group.Wait();
+    }
+
+    if (!rootNode.readable) {
+        return false;
+    }
+
+    Flatten(rootNode, tree);
+    return true;
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "DirectorySnapshot.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace RenamerCore {
+
+struct DirectoryTreeEntry {
+    // Index into DirectoryTree::directories of the folder holding the entry.
+    std::size_t parent;
+    DirectoryEntry entry;
+};
+
+struct DirectoryTree {
+    // Folder paths relative to the root; directories[0] is the root itself ("").
+    std::vector<std::wstring> directories;
+    // Depth-first: every folder's entries in natural order, each subfolder
+    // followed directly by its own contents.
+    std::vector<DirectoryTreeEntry> entries;
+    // Holds the names of `entries`, in the same order; sort keys are dropped.
+    EntryArena arena;
+    std::size_t unreadableCount = 0;
+};
+
+// Lists `root` and everything below it. Subfolders are read as separate tasks
+// on `pool`, but the result does not depend on scheduling. Symlinked folders
+// are reported as entries without being descended into. Returns false when
+// the root itself cannot be read; unreadable subfolders are only counted.
+// After a cancellation the scan stops early and `tree` is incomplete.
+bool ScanDirectoryTree(const std::filesystem::path& root, ThreadPool& pool, DirectoryTree& tree, const CancellationToken* cancellation = nullptr);
+
+} // namespace RenamerCore
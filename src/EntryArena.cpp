@@ -0,0 +1,99 @@
+#include "EntryArena.h"
+
+#include "NaturalSortKey.h"
+
+#include <algorithm>
+
+namespace RenamerCore {
+
+DirectoryEntry EntryArena::AddName(std::wstring_view name, bool isDirectory) {
+    DirectoryEntry entry;
+    entry.nameOffset = static_cast<std::uint32_t>(m_names.size());
+    entry.nameInfo = (static_cast<std::uint32_t>(name.size()) << 1) | (isDirectory ? 1U : 0U);
+    m_names.append(name);
+    return entry;
+}
+
+DirectoryEntry EntryArena::Add(std::wstring_view name, bool isDirectory) {
+    DirectoryEntry entry = AddName(name, isDirectory);
+    entry.keyOffset = static_cast<std::uint32_t>(m_keys.size());
+    AppendNaturalSortKey(name, m_keys);
+    entry.keyLength = static_cast<std::uint32_t>(m_keys.size() - entry.keyOffset);
+    return entry;
+}
+
+void EntryArena::BuildSortKeys(std::vector<DirectoryEntry>& entries, ThreadPool& pool, bool parallel) {
+    if (!parallel || pool.GetThreadCount() <= 1) {
+        m_keys.reserve(m_keys.size() + m_names.size() + entries.size() * 2);
+        for (DirectoryEntry& entry : entries) {
+            entry.keyOffset = static_cast<std::uint32_t>(m_keys.size());
+            AppendNaturalSortKey(GetName(entry), m_keys);
+            entry.keyLength = static_cast<std::uint32_t>(m_keys.size() - entry.keyOffset);
+        }
+        return;
+    }
+
+    // Every batch writes keys into its own buffer with batch-relative
+    // offsets; the buffers are then appended and the offsets rebased.
+    constexpr std::size_t kKeyBatchSize = 8192;
+    const std::size_t batchCount = (entries.size() + kKeyBatchSize - 1) / kKeyBatchSize;
+    std::vector<std::string> batchKeys(batchCount);
+    ParallelFor(pool, batchCount, [this, &entries, &batchKeys](std::size_t batch) {
+        const std::size_t end = (std::min)(entries.size(), (batch + 1) * kKeyBatchSize);
+        std::string& keys = batchKeys[batch];
+        for (std::size_t index = batch * kKeyBatchSize; index < end; ++index) {
+            DirectoryEntry& entry = entries[index];
+            entry.keyOffset = static_cast<std::uint32_t>(keys.size());
+            AppendNaturalSortKey(GetName(entry), keys);
+            entry.keyLength = static_cast<std::uint32_t>(keys.size() - entry.keyOffset);
+        }
+    });
+
+    std::size_t totalSize = m_keys.size();
+    for (const std::string& keys : batchKeys) {
+        totalSize += keys.size();
+    }
+    m_keys.reserve(totalSize);
+
+    for (std::size_t batch = 0; batch < batchCount; ++batch) {
+        const std::uint32_t base = static_cast<std::uint32_t>(m_keys.size());
+        m_keys.append(batchKeys[batch]);
+        const std::size_t end = (std::min)(entries.size(), (batch + 1) * kKeyBatchSize);
+        for (std::size_t index = batch * kKeyBatchSize; index < end; ++index) {
+            entries[index].keyOffset += base;
+        }
+    }
+}
+
+void EntryArena::Compact(std::vector<DirectoryEntry>& entries) {
+    std::size_t nameSize = 0;
+    std::size_t keySize = 0;
+    for (const DirectoryEntry& entry : entries) {
+        nameSize += entry.NameLength();
+        keySize += entry.keyLength;
+    }
+
+    std::wstring names;
+    std::string keys;
+    names.reserve(nameSize);
+    keys.reserve(keySize);
+
+    for (DirectoryEntry& entry : entries) {
+        const std::uint32_t nameOffset = static_cast<std::uint32_t>(names.size());
+        const std::uint32_t keyOffset = static_cast<std::uint32_t>(keys.size());
+        names.append(GetName(entry));
+        keys.append(GetSortKey(entry));
+        entry.nameOffset = nameOffset;
+        entry.keyOffset = keyOffset;
+    }
+
+    m_names = std::move(names);
+    m_keys = std::move(keys);
+}
+
+void EntryArena::Clear() {
+    m_names.clear();
+    m_keys.clear();
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RenamerCore {
+
+// Handle to a name (and optionally its natural sort key) stored in an
+// EntryArena. Offsets are positions in the arena buffers, so a listing is
+// limited to 4G characters of names, far above any real folder.
+struct DirectoryEntry {
+    std::uint32_t nameOffset = 0;
+    // Name length in the upper 31 bits, directory flag in the lowest one.
+    std::uint32_t nameInfo = 0;
+    std::uint32_t keyOffset = 0;
+    std::uint32_t keyLength = 0;
+
+    std::size_t NameLength() const { return nameInfo >> 1; }
+    bool IsDirectory() const { return (nameInfo & 1U) != 0; }
+};
+
+// Keeps all names of a listing in one contiguous buffer and their sort keys
+// in another, so a listing costs a handful of allocations instead of one or
+// two per entry. Views returned by the getters stay valid until the next
+// Add/AddName/BuildSortKeys/Compact/Clear call.
+class EntryArena {
+public:
+    // Stores the name only; the sort key is filled in by BuildSortKeys().
+    DirectoryEntry AddName(std::wstring_view name, bool isDirectory);
+    DirectoryEntry Add(std::wstring_view name, bool isDirectory);
+
+    // Builds the missing sort keys of `entries`. Batches run on `pool` when
+    // `parallel` is set and the pool has more than one thread.
+    void BuildSortKeys(std::vector<DirectoryEntry>& entries, ThreadPool& pool, bool parallel);
+
+    // Rewrites both buffers in the order of `entries`, dropping text no entry
+    // refers to and making the match pass read names sequentially.
+    void Compact(std::vector<DirectoryEntry>& entries);
+
+    void Clear();
+
+    std::wstring_view GetName(const DirectoryEntry& entry) const {
+        return std::wstring_view(m_names.data() + entry.nameOffset, entry.NameLength());
+    }
+
+    std::string_view GetSortKey(const DirectoryEntry& entry) const {
+        return std::string_view(m_keys.data() + entry.keyOffset, entry.keyLength);
+    }
+
+    std::size_t GetNameBufferSize() const { return m_names.size(); }
+
+    // Natural order: sort key first, raw name for equal keys.
+    bool Less(const DirectoryEntry& left, const DirectoryEntry& right) const {
+        const int compareResult = GetSortKey(left).compare(GetSortKey(right));
+        if (compareResult != 0) {
+            return compareResult < 0;
+        }
+        return GetName(left) < GetName(right);
+    }
+
+private:
+    std::wstring m_names;
+    std::string m_keys;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace RenamerCore {
+
+enum class FolderChangeAction {
+    Added,
+    Removed
+};
+
+// One entry-level change reported by a folder watcher. Renames arrive as a
+// Removed for the old name followed by an Added for the new one.
+struct FolderChange {
+    FolderChangeAction action;
+    std::wstring name;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,38 @@
+#include "LiteralMatcher.h"
+
+namespace RenamerCore {
+
+LiteralMatcher::LiteralMatcher(std::wstring_view pattern)
+    : m_pattern(pattern)
+    , m_search(GetSubstringSearch()) {
+}
+
+std::size_t LiteralMatcher::Find(std::wstring_view text, std::size_t start) const {
+    if (m_pattern.empty() || start >= text.size()) {
+        return std::wstring_view::npos;
+    }
+
+    const std::size_t found = m_search(text.substr(start), m_pattern);
+    return found == std::wstring_view::npos ? found : start + found;
+}
+
+bool LiteralMatcher::ReplaceAll(std::wstring_view text, std::wstring_view replacement, std::wstring& output) const {
+    std::size_t foundPos = Find(text);
+    if (foundPos == std::wstring_view::npos) {
+        return false;
+    }
+
+    output.clear();
+    std::size_t sourcePos = 0;
+    do {
+        output.append(text, sourcePos, foundPos - sourcePos);
+        output.append(replacement);
+        sourcePos = foundPos + m_pattern.size();
+        foundPos = Find(text, sourcePos);
+    } while (foundPos != std::wstring_view::npos);
+
+    output.append(text, sourcePos, std::wstring_view::npos);
+    return true;
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SubstringSearch.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace RenamerCore {
+
+// Case-sensitive literal search on the vectorized substring kernel chosen
+// for this CPU. ReplaceAll finds and replaces in one scan of the text.
+class LiteralMatcher {
+public:
+    explicit LiteralMatcher(std::wstring_view pattern);
+
+    // Position of the first match at or after `start`, or npos.
+    std::size_t Find(std::wstring_view text, std::size_t start = 0) const;
+
+    // Replaces every non-overlapping match. Returns false, leaving `output`
+    // untouched, when the text does not match at all.
+    bool ReplaceAll(std::wstring_view text, std::wstring_view replacement, std::wstring& output) const;
+
+private:
+    std::wstring m_pattern;
+    SubstringSearchFunction m_search;
+};
+
+} // namespace RenamerCore
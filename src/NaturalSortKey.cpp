@@ -0,0 +1,90 @@
+#include "NaturalSortKey.h"
+
+#include "CaseFolding.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cwchar>
+
+namespace {
+
+bool IsDigit(wchar_t ch) {
+    return ch >= L'0' && ch <= L'9';
+}
+
+void AppendUtf8(std::uint32_t codePoint, std::string& key) {
+    if (codePoint < 0x80) {
+        key.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        key.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        key.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        key.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        key.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        key.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        key.push_back(static_cast<char>(0xF0 | ((codePoint >> 18) & 0x07)));
+        key.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        key.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        key.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+// Reads one code point, joining UTF-16 surrogate pairs where wchar_t is
+// 16 bits so that both platforms order by code point.
+std::uint32_t ReadCodePoint(std::wstring_view name, size_t& position) {
+    const std::uint32_t unit = static_cast<std::uint32_t>(name[position++]);
+#if WCHAR_MAX <= 0xFFFF
+    if (unit >= 0xD800 && unit <= 0xDBFF && position < name.size()) {
+        const std::uint32_t low = static_cast<std::uint32_t>(name[position]);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            ++position;
+            return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+    }
+#endif
+    return unit;
+}
+
+} // namespace
+
+namespace RenamerCore {
+
+void AppendNaturalSortKey(std::wstring_view name, std::string& key) {
+    size_t position = 0;
+    while (position < name.size()) {
+        if (!IsDigit(name[position])) {
+            const std::uint32_t codePoint = ReadCodePoint(name, position);
+            const std::uint32_t folded = codePoint <= 0xFFFF
+                ? static_cast<std::uint32_t>(SimpleToLower(static_cast<wchar_t>(codePoint)))
+                : codePoint;
+            AppendUtf8(folded, key);
+            continue;
+        }
+
+        while (position < name.size() && name[position] == L'0') {
+            ++position;
+        }
+        const size_t digitsBegin = position;
+        while (position < name.size() && IsDigit(name[position])) {
+            ++position;
+        }
+
+        // A path component is at most 255 characters long, so the count fits.
+        const size_t digitCount = (std::min)(position - digitsBegin, static_cast<size_t>(255));
+        key.push_back('0');
+        key.push_back(static_cast<char>(digitCount));
+        for (size_t index = digitsBegin; index < digitsBegin + digitCount; ++index) {
+            key.push_back(static_cast<char>(name[index]));
+        }
+    }
+}
+
+std::string MakeNaturalSortKey(std::wstring_view name) {
+    std::string key;
+    key.reserve(name.size() + 4);
+    AppendNaturalSortKey(name, key);
+    return key;
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace RenamerCore {
+
+// Builds a byte key whose plain lexicographic (memcmp) order is the natural
+// order of file names: text is compared case-insensitively by code point and
+// digit runs by numeric value, ignoring leading zeros. The encoding does not
+// depend on the platform, so Windows and Linux sort identically.
+//
+// Layout: each non-digit character is its folded code point in UTF-8; each
+// digit run is '0', a byte with the count of significant digits, then those
+// digits. Names with equal keys should be ordered by their raw text.
+std::string MakeNaturalSortKey(std::wstring_view name);
+
+// Same key, appended to `key` so that many keys can share one buffer.
+void AppendNaturalSortKey(std::wstring_view name, std::string& key);
+
+} // namespace RenamerCore
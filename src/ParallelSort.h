@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace RenamerCore {
+
+namespace ParallelSortDetail {
+
+// Number of elements taken from `left` among the first `outputIndex` elements
+// of the stable merge of `left` and `right` (merge-path co-ranking).
+template <typename T, typename Less>
+std::size_t CoRank(std::size_t outputIndex,
+                   const T* left,
+                   std::size_t leftSize,
+                   const T* right,
+                   std::size_t rightSize,
+                   Less& less) {
+    std::size_t low = outputIndex > rightSize ? outputIndex - rightSize : 0;
+    std::size_t high = (std::min)(outputIndex, leftSize);
+
+    while (low < high) {
+        const std::size_t leftTaken = low + (high - low) / 2;
+        const std::size_t rightTaken = outputIndex - leftTaken;
+        if (rightTaken > 0 && !less(right[rightTaken - 1], left[leftTaken])) {
+            low = leftTaken + 1;
+        } else {
+            high = leftTaken;
+        }
+    }
+    return low;
+}
+
+} // namespace ParallelSortDetail
+
+// Chunked sort on the pool followed by rounds of pairwise merges, each merge
+// split across workers by co-ranking. With a strict weak ordering whose
+// equivalent elements are indistinguishable the result equals std::sort's;
+// ties are resolved stably otherwise.
+template <typename T, typename Less>
+void ParallelSort(std::vector<T>& items, Less less, ThreadPool& pool) {
+    constexpr std::size_t kMinChunkSize = 4096;
+
+    const std::size_t count = items.size();
+    const std::size_t threadCount = pool.GetThreadCount();
+
+    std::size_t chunkCount = 1;
+    while (chunkCount * 2 <= threadCount && count / (chunkCount * 2) >= kMinChunkSize) {
+        chunkCount *= 2;
+    }
+
+    if (chunkCount < 2) {
+        std::stable_sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    std::vector<std::size_t> bounds(chunkCount + 1);
+    for (std::size_t index = 0; index <= chunkCount; ++index) {
+        bounds[index] = count * index / chunkCount;
+    }
+
+    ParallelFor(pool, chunkCount, [&](std::size_t chunk) {
+        std::stable_sort(items.begin() + bounds[chunk], items.begin() + bounds[chunk + 1], less);
+    });
+
+    std::vector<T> buffer(count);
+    std::vector<T>* source = &items;
+    std::vector<T>* target = &buffer;
+
+    for (std::size_t width = 1; width < chunkCount; width *= 2) {
+        const std::size_t pairCount = chunkCount / (width * 2);
+        const std::size_t partsPerPair = (std::max<std::size_t>)(1, threadCount / pairCount);
+
+        // Splits are computed before any element is moved out of `source`.
+        struct MergeTask {
+            std::size_t leftBegin;
+            std::size_t leftEnd;
+            std::size_t rightBegin;
+            std::size_t rightEnd;
+            std::size_t outputBegin;
+        };
+
+        std::vector<MergeTask> tasks;
+        tasks.reserve(pairCount * partsPerPair);
+        for (std::size_t pair = 0; pair < pairCount; ++pair) {
+            const std::size_t begin = bounds[pair * width * 2];
+            const std::size_t middle = bounds[pair * width * 2 + width];
+            const std::size_t end = bounds[pair * width * 2 + width * 2];
+
+            const T* left = source->data() + begin;
+            const T* right = source->data() + middle;
+            const std::size_t leftSize = middle - begin;
+            const std::size_t rightSize = end - middle;
+            const std::size_t total = end - begin;
+
+            for (std::size_t part = 0; part < partsPerPair; ++part) {
+                const std::size_t outputBegin = total * part / partsPerPair;
+                const std::size_t outputEnd = total * (part + 1) / partsPerPair;
+                const std::size_t leftBegin = ParallelSortDetail::CoRank(outputBegin, left, leftSize, right, rightSize, less);
+                const std::size_t leftEnd = ParallelSortDetail::CoRank(outputEnd, left, leftSize, right, rightSize, less);
+                tasks.push_back({
+                    begin + leftBegin,
+                    begin + leftEnd,
+                    middle + outputBegin - leftBegin,
+                    middle + outputEnd - leftEnd,
+                    begin + outputBegin
+                });
+            }
+        }
+
+        ParallelFor(pool, tasks.size(), [&](std::size_t taskIndex) {
+            const MergeTask& task = tasks[taskIndex];
+            T* sourceData = source->data();
+            std::merge(
+                std::make_move_iterator(sourceData + task.leftBegin),
+                std::make_move_iterator(sourceData + task.leftEnd),
+                std::make_move_iterator(sourceData + task.rightBegin),
+                std::make_move_iterator(sourceData + task.rightEnd),
+                target->data() + task.outputBegin,
+                less
+            );
+        });
+
+        std::swap(source, target);
+    }
+
+    if (source != &items) {
+        items.swap(buffer);
+    }
+}
+
+} // namespace RenamerCore
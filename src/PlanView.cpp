@@ -0,0 +1,58 @@
+#include "PlanView.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace RenamerCore {
+
+PlanView::PlanView(fs::path root, Rename rename)
+    : m_root(std::move(root))
+    , m_rename(std::move(rename))
+    , m_folders { std::wstring() }
+    , m_offsets { 0 } {
+}
+
+std::uint32_t PlanView::AddFolder(const std::wstring& relativePath) {
+    if (relativePath.empty()) {
+        return 0;
+    }
+
+    m_folders.push_back(relativePath);
+    return static_cast<std::uint32_t>(m_folders.size() - 1);
+}
+
+void PlanView::Add(std::uint32_t folder, std::wstring_view name, bool isDirectory) {
+    m_names.append(name);
+    m_entryFolders.push_back(folder);
+    m_offsets.push_back(static_cast<std::uint32_t>(m_names.size()));
+    m_directoryFlags.push_back(isDirectory);
+}
+
+RenamePlan PlanView::GetRange(std::size_t offset, std::size_t count) const {
+    RenamePlan page(m_root);
+    const std::size_t begin = (std::min)(offset, size());
+    const std::size_t end = begin + (std::min)(count, size() - begin);
+
+    constexpr std::uint32_t kNoFolder = UINT32_MAX;
+    std::vector<std::uint32_t> pageFolders(m_folders.size(), kNoFolder);
+    pageFolders[0] = 0;
+
+    std::wstring newName;
+    for (std::size_t index = begin; index < end; ++index) {
+        std::uint32_t& folder = pageFolders[m_entryFolders[index]];
+        if (folder == kNoFolder) {
+            folder = page.AddFolder(m_folders[m_entryFolders[index]]);
+        }
+
+        const std::wstring_view name(m_names.data() + m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+        if (!m_rename || !m_rename(name, m_directoryFlags[index], newName)) {
+            newName.assign(name);
+        }
+        page.Add(folder, name, newName, m_directoryFlags[index]);
+    }
+    return page;
+}
+
+} // namespace RenamerCore
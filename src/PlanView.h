@@ -0,0 +1,53 @@
+#pragma once
+
+#include "RenamePlan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RenamerCore {
+
+// Every match of a collection, kept as old names only. New names are
+// computed when a range of rows is requested, so a view of millions of
+// matches costs its names plus a few bytes per entry, and a UI only pays
+// for the rows it shows. Not safe to use from several threads at once,
+// since the rename function may keep matcher scratch.
+class PlanView {
+public:
+    // Computes the new name of a matched entry; see CollectOperations.
+    using Rename = std::function<bool(std::wstring_view name, bool isDirectory, std::wstring& newName)>;
+
+    explicit PlanView(std::filesystem::path root = {}, Rename rename = {});
+
+    const std::filesystem::path& GetRoot() const { return m_root; }
+
+    // Same folder numbering as RenamePlan: the root is folder 0.
+    std::uint32_t AddFolder(const std::wstring& relativePath);
+    void Add(std::uint32_t folder, std::wstring_view name, bool isDirectory);
+
+    std::size_t size() const { return m_entryFolders.size(); }
+    bool empty() const { return m_entryFolders.empty(); }
+
+    // Rows [offset, offset + count), cut at size(), as a plan of their own
+    // with the new names filled in.
+    RenamePlan GetRange(std::size_t offset, std::size_t count) const;
+
+private:
+    std::filesystem::path m_root;
+    Rename m_rename;
+    std::vector<std::wstring> m_folders;
+
+    std::wstring m_names;
+    std::vector<std::uint32_t> m_entryFolders;
+    // One more element than there are entries: entry i spans
+    // [m_offsets[i], m_offsets[i + 1]) of m_names.
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<bool> m_directoryFlags;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FolderChanges.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace RenamerCore::Platform {
+
+std::filesystem::path ToPath(const std::wstring& text);
+std::wstring ToWide(const std::filesystem::path& path);
+
+std::wstring ToLower(const std::wstring& text);
+// Lowercase mapping of every UTF-16 code unit (0x10000 entries), equal to
+// ToLower applied character by character. Built once, on first use.
+const wchar_t* GetLowerCaseTable();
+std::wstring PathKey(const std::filesystem::path& path);
+std::wstring MakeTempSuffix();
+// Cheap identity + timestamps of a directory, used to tell whether a
+// cached listing is still current. Times are nanoseconds since the Unix epoch.
+struct DirectoryStamp {
+    std::uint64_t volumeId = 0;
+    std::uint64_t fileId = 0;
+    std::int64_t modifiedTime = 0;
+    std::int64_t changedTime = 0;
+
+    bool operator==(const DirectoryStamp& other) const {
+        return volumeId == other.volumeId
+            && fileId == other.fileId
+            && modifiedTime == other.modifiedTime
+            && changedTime == other.changedTime;
+    }
+
+    bool operator!=(const DirectoryStamp& other) const {
+        return !(*this == other);
+    }
+};
+
+// Returns false when the path does not exist or is not a directory.
+bool GetDirectoryStamp(const std::filesystem::path& folder, DirectoryStamp& stamp);
+
+// Reports regular files and directories (symlinks are followed, other
+// types are skipped). Entry types come from the bulk directory read and a
+// stat call is only issued when the filesystem does not provide one.
+// Returning false from the callback stops the enumeration, which then
+// returns false as well.
+using DirectoryEntryCallback = std::function<bool(std::wstring_view name, bool isDirectory)>;
+bool EnumerateDirectory(const std::filesystem::path& folder, const DirectoryEntryCallback& onEntry);
+
+enum class EntryType {
+    Other,
+    File,
+    Directory
+};
+
+// Follows symlinks; missing entries and special files report Other.
+EntryType GetEntryType(const std::filesystem::path& path);
+
+// Decodes a buffer filled by the native watcher (FILE_NOTIFY_INFORMATION
+// records on Windows, inotify_event records on Linux) into entry changes.
+// Returns false when the records report lost events or that the watched
+// folder itself went away; the caller must then rescan the folder.
+bool ParseFolderChanges(const void* records, std::size_t size, std::vector<FolderChange>& changes);
+
+void RenamePath(const std::filesystem::path& from, const std::filesystem::path& to, std::error_code& ec);
+
+} // namespace RenamerCore::Platform
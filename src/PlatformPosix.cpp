@@ -0,0 +1,400 @@
+#include "Platform.h"
+
+#include "CaseFolding.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Undecodable bytes are kept as lone surrogates U+DC80..U+DCFF so that
+// names which are not valid UTF-8 still round-trip through std::wstring.
+std::wstring DecodeUtf8(const std::string& text) {
+    std::wstring result;
+    result.reserve(text.size());
+
+    size_t position = 0;
+    while (position < text.size()) {
+        const unsigned char lead = static_cast<unsigned char>(text[position]);
+        if (lead < 0x80) {
+            result.push_back(static_cast<wchar_t>(lead));
+            ++position;
+            continue;
+        }
+
+        size_t length = 0;
+        std::uint32_t codePoint = 0;
+        std::uint32_t minimum = 0;
+        if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            codePoint = lead & 0x1F;
+            minimum = 0x80;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            codePoint = lead & 0x0F;
+            minimum = 0x800;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+
+        bool valid = length > 0 && position + length <= text.size();
+        for (size_t index = 1; valid && index < length; ++index) {
+            const unsigned char trail = static_cast<unsigned char>(text[position + index]);
+            if ((trail & 0xC0) != 0x80) {
+                valid = false;
+                break;
+            }
+            codePoint = (codePoint << 6) | (trail & 0x3F);
+        }
+
+        valid = valid
+            && codePoint >= minimum
+            && codePoint <= 0x10FFFF
+            && (codePoint < 0xD800 || codePoint > 0xDFFF);
+
+        if (!valid) {
+            result.push_back(static_cast<wchar_t>(0xDC00 + lead));
+            ++position;
+            continue;
+        }
+
+        result.push_back(static_cast<wchar_t>(codePoint));
+        position += length;
+    }
+
+    return result;
+}
+
+std::string EncodeUtf8(const std::wstring& text) {
+    std::string result;
+    result.reserve(text.size());
+
+    for (const wchar_t ch : text) {
+        const std::uint32_t codePoint = static_cast<std::uint32_t>(ch);
+        if (codePoint < 0x80) {
+            result.push_back(static_cast<char>(codePoint));
+        } else if (codePoint >= 0xDC80 && codePoint <= 0xDCFF) {
+            result.push_back(static_cast<char>(codePoint - 0xDC00));
+        } else if (codePoint < 0x800) {
+            result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            result.push_back(static_cast<char>(0xF0 | ((codePoint >> 18) & 0x07)));
+            result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    return result;
+}
+
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd)
+        : m_fd(fd) {
+    }
+
+    ~FileDescriptor() {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int get() const {
+        return m_fd;
+    }
+
+private:
+    int m_fd;
+};
+
+enum class EntryKind {
+    Skip,
+    File,
+    Directory
+};
+
+EntryKind ClassifyEntry(int directoryFd, const char* name, unsigned char type) {
+    switch (type) {
+    case DT_REG:
+        return EntryKind::File;
+    case DT_DIR:
+        return EntryKind::Directory;
+    case DT_LNK:
+    case DT_UNKNOWN:
+        break;
+    default:
+        return EntryKind::Skip;
+    }
+
+    struct stat info = {};
+    if (fstatat(directoryFd, name, &info, 0) != 0) {
+        return EntryKind::Skip;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        return EntryKind::Directory;
+    }
+    if (S_ISREG(info.st_mode)) {
+        return EntryKind::File;
+    }
+    return EntryKind::Skip;
+}
+
+bool IsDotEntry(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+#ifdef __linux__
+struct LinuxDirent64 {
+    std::uint64_t d_ino;
+    std::int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool ReadDirectoryEntries(int directoryFd, const RenamerCore::Platform::DirectoryEntryCallback& onEntry) {
+    constexpr size_t kBufferSize = 256 * 1024;
+    std::vector<char> buffer(kBufferSize);
+    std::wstring name;
+
+    for (;;) {
+        const long bytesRead = syscall(SYS_getdents64, directoryFd, buffer.data(), buffer.size());
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (bytesRead == 0) {
+            return true;
+        }
+
+        for (long offset = 0; offset < bytesRead;) {
+            const auto* record = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+            offset += record->d_reclen;
+
+            if (IsDotEntry(record->d_name)) {
+                continue;
+            }
+
+            const EntryKind kind = ClassifyEntry(directoryFd, record->d_name, record->d_type);
+            if (kind == EntryKind::Skip) {
+                continue;
+            }
+
+            name = DecodeUtf8(record->d_name);
+            if (!onEntry(name, kind == EntryKind::Directory)) {
+                return false;
+            }
+        }
+    }
+}
+#else
+bool ReadDirectoryEntries(int directoryFd, const RenamerCore::Platform::DirectoryEntryCallback& onEntry) {
+    const int streamFd = dup(directoryFd);
+    if (streamFd < 0) {
+        return false;
+    }
+
+    DIR* directory = fdopendir(streamFd);
+    if (!directory) {
+        close(streamFd);
+        return false;
+    }
+
+    bool success = true;
+    std::wstring name;
+    for (;;) {
+        errno = 0;
+        const dirent* record = readdir(directory);
+        if (!record) {
+            success = errno == 0;
+            break;
+        }
+
+        if (IsDotEntry(record->d_name)) {
+            continue;
+        }
+
+        const EntryKind kind = ClassifyEntry(directoryFd, record->d_name, record->d_type);
+        if (kind == EntryKind::Skip) {
+            continue;
+        }
+
+        name = DecodeUtf8(record->d_name);
+        if (!onEntry(name, kind == EntryKind::Directory)) {
+            success = false;
+            break;
+        }
+    }
+
+    closedir(directory);
+    return success;
+}
+#endif
+
+} // namespace
+
+namespace RenamerCore::Platform {
+
+fs::path ToPath(const std::wstring& text) {
+    return fs::path(EncodeUtf8(text));
+}
+
+std::wstring ToWide(const fs::path& path) {
+    return DecodeUtf8(path.native());
+}
+
+std::wstring ToLower(const std::wstring& text) {
+    return SimpleToLowerCopy(text);
+}
+
+const wchar_t* GetLowerCaseTable() {
+    static const std::vector<wchar_t> table = []() {
+        std::vector<wchar_t> lowered(0x10000);
+        for (std::size_t code = 0; code < lowered.size(); ++code) {
+            lowered[code] = SimpleToLower(static_cast<wchar_t>(code));
+        }
+        return lowered;
+    }();
+    return table.data();
+}
+
+std::wstring PathKey(const fs::path& path) {
+    std::error_code absoluteEc;
+    const fs::path absolutePath = fs::absolute(path, absoluteEc);
+    return ToWide(absoluteEc ? path : absolutePath.lexically_normal());
+}
+
+std::wstring MakeTempSuffix() {
+    static std::atomic<std::uint64_t> counter { 0 };
+    static thread_local std::mt19937_64 generator { std::random_device {}() };
+
+    wchar_t token[64] = {};
+    std::swprintf(
+        token,
+        64,
+        L"%08x%016llx%08llx",
+        static_cast<unsigned>(getpid()),
+        static_cast<unsigned long long>(generator()),
+        static_cast<unsigned long long>(counter.fetch_add(1) & 0xFFFFFFFFULL)
+    );
+
+    return std::wstring(L".renamer_tmp_") + token;
+}
+
+bool GetDirectoryStamp(const fs::path& folder, DirectoryStamp& stamp) {
+    struct stat info = {};
+    if (stat(folder.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        return false;
+    }
+
+#ifdef __APPLE__
+    const timespec& modified = info.st_mtimespec;
+    const timespec& changed = info.st_ctimespec;
+#else
+    const timespec& modified = info.st_mtim;
+    const timespec& changed = info.st_ctim;
+#endif
+
+    stamp.volumeId = static_cast<std::uint64_t>(info.st_dev);
+    stamp.fileId = static_cast<std::uint64_t>(info.st_ino);
+    stamp.modifiedTime = static_cast<std::int64_t>(modified.tv_sec) * 1000000000LL + modified.tv_nsec;
+    stamp.changedTime = static_cast<std::int64_t>(changed.tv_sec) * 1000000000LL + changed.tv_nsec;
+    return true;
+}
+
+bool EnumerateDirectory(const fs::path& folder, const DirectoryEntryCallback& onEntry) {
+    const FileDescriptor directoryFd(open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (directoryFd.get() < 0) {
+        return false;
+    }
+
+    return ReadDirectoryEntries(directoryFd.get(), onEntry);
+}
+
+EntryType GetEntryType(const fs::path& path) {
+    struct stat info = {};
+    if (stat(path.c_str(), &info) != 0) {
+        return EntryType::Other;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        return EntryType::Directory;
+    }
+    return S_ISREG(info.st_mode) ? EntryType::File : EntryType::Other;
+}
+
+#ifdef __linux__
+bool ParseFolderChanges(const void* records, std::size_t size, std::vector<FolderChange>& changes) {
+    constexpr std::uint32_t kRescanMask = IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT;
+    const auto* bytes = static_cast<const char*>(records);
+    std::size_t offset = 0;
+    bool complete = true;
+
+    while (offset + sizeof(inotify_event) <= size) {
+        inotify_event event = {};
+        std::memcpy(&event, bytes + offset, sizeof(event));
+        const char* name = bytes + offset + sizeof(inotify_event);
+        offset += sizeof(inotify_event) + event.len;
+
+        if (event.mask & kRescanMask) {
+            complete = false;
+            continue;
+        }
+
+        if (event.len == 0 || offset > size) {
+            continue;
+        }
+
+        const std::wstring decodedName = DecodeUtf8(std::string(name, strnlen(name, event.len)));
+        if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+            changes.push_back({ FolderChangeAction::Added, decodedName });
+        } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+            changes.push_back({ FolderChangeAction::Removed, decodedName });
+        }
+    }
+
+    return complete;
+}
+#else
+bool ParseFolderChanges(const void*, std::size_t, std::vector<FolderChange>&) {
+    return false;
+}
+#endif
+
+void RenamePath(const fs::path& from, const fs::path& to, std::error_code& ec) {
+    ec.clear();
+    if (::rename(from.c_str(), to.c_str()) != 0) {
+        ec.assign(errno, std::generic_category());
+    }
+}
+
+} // namespace RenamerCore::Platform
@@ -0,0 +1,274 @@
+#include "Platform.h"
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <windows.h>
+#include <objbase.h>
+
+#include <algorithm>
+#include <cwctype>
+#include <vector>
+
+#pragma comment(lib, "Ole32.lib")
+
+namespace fs = std::filesystem;
+
+namespace RenamerCore::Platform {
+
+fs::path ToPath(const std::wstring& text) {
+    return fs::path(text);
+}
+
+std::wstring ToWide(const fs::path& path) {
+    return path.wstring();
+}
+
+std::wstring ToLower(const std::wstring& text) {
+    if (text.empty()) {
+        return text;
+    }
+
+    const int required = LCMapStringEx(
+        LOCALE_NAME_INVARIANT,
+        LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING,
+        text.c_str(),
+        -1,
+        nullptr,
+        0,
+        nullptr,
+        nullptr,
+        0
+    );
+    if (required > 1) {
+        std::wstring lowered(static_cast<size_t>(required), L'\0');
+        const int written = LCMapStringEx(
+            LOCALE_NAME_INVARIANT,
+            LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING,
+            text.c_str(),
+            -1,
+            lowered.data(),
+            required,
+            nullptr,
+            nullptr,
+            0
+        );
+        if (written > 0) {
+            lowered.resize(static_cast<size_t>(written - 1));
+            return lowered;
+        }
+    }
+
+    std::wstring lowered = text;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](wchar_t ch) {
+        return static_cast<wchar_t>(std::towlower(ch));
+    });
+    return lowered;
+}
+
+const wchar_t* GetLowerCaseTable() {
+    static const std::vector<wchar_t> table = []() {
+        std::vector<wchar_t> source(0x10000);
+        for (std::size_t code = 0; code < source.size(); ++code) {
+            source[code] = static_cast<wchar_t>(code);
+        }
+
+        // Lowercasing maps code units one to one, so the whole range can be
+        // mapped at once. Surrogates are left out and keep their value.
+        std::vector<wchar_t> lowered = source;
+        auto mapRange = [&source, &lowered](std::size_t first, std::size_t last) {
+            const int count = static_cast<int>(last - first);
+            const int written = LCMapStringEx(
+                LOCALE_NAME_INVARIANT,
+                LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING,
+                source.data() + first,
+                count,
+                lowered.data() + first,
+                count,
+                nullptr,
+                nullptr,
+                0
+            );
+            if (written != count) {
+                for (std::size_t code = first; code < last; ++code) {
+                    lowered[code] = static_cast<wchar_t>(std::towlower(source[code]));
+                }
+            }
+        };
+        mapRange(0, 0xD800);
+        mapRange(0xE000, 0x10000);
+        return lowered;
+    }();
+    return table.data();
+}
+
+std::wstring PathKey(const fs::path& path) {
+    std::error_code absoluteEc;
+    const fs::path absolutePath = fs::absolute(path, absoluteEc);
+    std::wstring key = absoluteEc ? path.wstring() : absolutePath.lexically_normal().wstring();
+    return ToLower(key);
+}
+
+std::wstring MakeTempSuffix() {
+    GUID guid = {};
+    if (FAILED(CoCreateGuid(&guid))) {
+        return L".renamer_tmp_fallback_" + std::to_wstring(GetTickCount64());
+    }
+
+    wchar_t guidBuffer[64] = {};
+    StringFromGUID2(guid, guidBuffer, 64);
+
+    std::wstring token = guidBuffer;
+    token.erase(
+        std::remove_if(token.begin(), token.end(), [](wchar_t ch) {
+            return ch == L'{' || ch == L'}' || ch == L'-';
+        }),
+        token.end()
+    );
+
+    return L".renamer_tmp_" + token;
+}
+
+bool GetDirectoryStamp(const fs::path& folder, DirectoryStamp& stamp) {
+    HANDLE handle = CreateFileW(
+        folder.c_str(),
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS,
+        nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION info = {};
+    // Only FILE_BASIC_INFO carries the metadata change time.
+    FILE_BASIC_INFO basicInfo = {};
+    const BOOL queried = GetFileInformationByHandle(handle, &info)
+        && GetFileInformationByHandleEx(handle, FileBasicInfo, &basicInfo, sizeof(basicInfo));
+    CloseHandle(handle);
+    if (!queried || !(info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return false;
+    }
+
+    auto toUnixNanoseconds = [](std::int64_t ticks) {
+        constexpr std::int64_t kUnixEpochIn100ns = 116444736000000000LL;
+        return (ticks - kUnixEpochIn100ns) * 100;
+    };
+
+    stamp.volumeId = info.dwVolumeSerialNumber;
+    stamp.fileId = (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    stamp.modifiedTime = toUnixNanoseconds(basicInfo.LastWriteTime.QuadPart);
+    stamp.changedTime = toUnixNanoseconds(basicInfo.ChangeTime.QuadPart);
+    return true;
+}
+
+bool EnumerateDirectory(const fs::path& folder, const DirectoryEntryCallback& onEntry) {
+    const std::wstring searchPattern = (folder / L"*").wstring();
+
+    WIN32_FIND_DATAW data = {};
+    HANDLE findHandle = FindFirstFileExW(
+        searchPattern.c_str(),
+        FindExInfoBasic,
+        &data,
+        FindExSearchNameMatch,
+        nullptr,
+        FIND_FIRST_EX_LARGE_FETCH
+    );
+    if (findHandle == INVALID_HANDLE_VALUE) {
+        // An empty volume root has no "." or ".." either, so nothing matches
+        // "*"; a missing folder fails with ERROR_PATH_NOT_FOUND instead.
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+
+    bool success = true;
+    do {
+        const std::wstring_view name(data.cFileName);
+        if (name == L"." || name == L"..") {
+            continue;
+        }
+
+        bool isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            std::error_code statusEc;
+            const fs::file_status status = fs::status(folder / name, statusEc);
+            if (statusEc) {
+                continue;
+            }
+            if (!fs::is_directory(status) && !fs::is_regular_file(status)) {
+                continue;
+            }
+            isDirectory = fs::is_directory(status);
+        } else if (data.dwFileAttributes & FILE_ATTRIBUTE_DEVICE) {
+            continue;
+        }
+
+        if (!onEntry(name, isDirectory)) {
+            FindClose(findHandle);
+            return false;
+        }
+    } while (FindNextFileW(findHandle, &data));
+
+    if (GetLastError() != ERROR_NO_MORE_FILES) {
+        success = false;
+    }
+
+    FindClose(findHandle);
+    return success;
+}
+
+EntryType GetEntryType(const fs::path& path) {
+    std::error_code statusEc;
+    const fs::file_status status = fs::status(path, statusEc);
+    if (statusEc) {
+        return EntryType::Other;
+    }
+    if (fs::is_directory(status)) {
+        return EntryType::Directory;
+    }
+    return fs::is_regular_file(status) ? EntryType::File : EntryType::Other;
+}
+
+bool ParseFolderChanges(const void* records, std::size_t size, std::vector<FolderChange>& changes) {
+    const auto* bytes = static_cast<const std::uint8_t*>(records);
+    std::size_t offset = 0;
+
+    while (offset + sizeof(FILE_NOTIFY_INFORMATION) <= size) {
+        const auto* record = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(bytes + offset);
+        const std::wstring name(record->FileName, record->FileNameLength / sizeof(WCHAR));
+
+        if (!name.empty() && name.find(L'\\') == std::wstring::npos) {
+            switch (record->Action) {
+            case FILE_ACTION_ADDED:
+            case FILE_ACTION_RENAMED_NEW_NAME:
+                changes.push_back({ FolderChangeAction::Added, name });
+                break;
+            case FILE_ACTION_REMOVED:
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                changes.push_back({ FolderChangeAction::Removed, name });
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (record->NextEntryOffset == 0) {
+            break;
+        }
+        offset += record->NextEntryOffset;
+    }
+
+    return true;
+}
+
+void RenamePath(const fs::path& from, const fs::path& to, std::error_code& ec) {
+    ec.clear();
+    if (!MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+    }
+}
+
+} // namespace RenamerCore::Platform
@@ -0,0 +1,139 @@
+#include "PreviewService.h"
+
+#include <iterator>
+#include <utility>
+
+namespace RenamerCore {
+
+PreviewService::PreviewService(ReadyCallback onReady)
+    : m_onReady(std::move(onReady))
+    , m_worker(&PreviewService::WorkerLoop, this) {
+}
+
+PreviewService::~PreviewService() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_cancellation.Cancel();
+    }
+    m_wake.notify_one();
+    m_worker.join();
+}
+
+std::uint64_t PreviewService::Request(PreviewRequest request) {
+    std::uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending) {
+            PreviewRequest& dropped = *m_pending;
+            dropped.folderChanges.insert(
+                dropped.folderChanges.end(),
+                std::make_move_iterator(request.folderChanges.begin()),
+                std::make_move_iterator(request.folderChanges.end())
+            );
+            request.folderChanges = std::move(dropped.folderChanges);
+            request.rescanRequired = request.rescanRequired || dropped.rescanRequired;
+        }
+
+        request.options.cancellation = &m_cancellation;
+        m_pending = std::move(request);
+        m_result.reset();
+        generation = ++m_generation;
+        m_cancellation.Cancel();
+    }
+    m_wake.notify_one();
+    return generation;
+}
+
+bool PreviewService::TakeResult(PreviewResult& result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_result) {
+        return false;
+    }
+    result = std::move(*m_result);
+    m_result.reset();
+    return true;
+}
+
+bool PreviewService::WaitForResult(PreviewResult& result, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_resultReady.wait_for(lock, timeout, [this]() { return m_result.has_value(); })) {
+        return false;
+    }
+    result = std::move(*m_result);
+    m_result.reset();
+    return true;
+}
+
+std::uint64_t PreviewService::GetGeneration() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+void PreviewService::WorkerLoop() {
+    for (;;) {
+        PreviewRequest request;
+        std::uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || m_pending.has_value(); });
+            if (m_stopping) {
+                return;
+            }
+            request = std::move(*m_pending);
+            m_pending.reset();
+            generation = m_generation;
+            // Requests cancel under the lock, so a reset here can only
+            // clear cancellations aimed at jobs that no longer exist.
+            m_cancellation.Reset();
+        }
+
+        request.options.onProgress = [this, generation](const CollectProgress& progress) {
+            PublishProgress(generation, progress);
+        };
+
+        if (request.rescanRequired) {
+            m_snapshot.Invalidate();
+        } else if (!request.folderChanges.empty() && !m_snapshot.ApplyChanges(request.folderChanges)) {
+            m_snapshot.Invalidate();
+        }
+
+        CollectResult collect = CollectOperations(m_snapshot, request.folder, request.pattern, request.replacement, request.options);
+        if (collect.cancelled) {
+            continue;
+        }
+
+        Publish(PreviewResult { generation, true, std::move(collect) });
+    }
+}
+
+void PreviewService::PublishProgress(std::uint64_t generation, const CollectProgress& progress) {
+    PreviewResult partial;
+    partial.generation = generation;
+    partial.complete = false;
+    partial.collect.operations = progress.operations;
+    partial.collect.totalCount = progress.matchCount;
+    partial.collect.stats.estimate = progress.estimate;
+    partial.collect.status = L"Идет поиск, найдено совпадений: " + std::to_wstring(progress.matchCount);
+    if (progress.estimate.sampleCount > 0) {
+        partial.collect.status += L", всего около " + std::to_wstring(progress.estimate.count)
+            + L" (" + std::to_wstring(progress.estimate.low) + L"–" + std::to_wstring(progress.estimate.high) + L")";
+    }
+    Publish(std::move(partial));
+}
+
+void PreviewService::Publish(PreviewResult&& result) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (result.generation != m_generation) {
+            return;
+        }
+        m_result = std::move(result);
+    }
+    m_resultReady.notify_all();
+    if (m_onReady) {
+        m_onReady();
+    }
+}
+
+} // namespace RenamerCore
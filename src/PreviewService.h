@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "DirectorySnapshot.h"
+#include "FolderChanges.h"
+#include "RenamerService.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace RenamerCore {
+
+struct PreviewRequest {
+    std::wstring folder;
+    std::wstring pattern;
+    std::wstring replacement;
+    CollectOptions options;
+    // Watcher deltas seen since the previous request. They are applied to
+    // the snapshot before collecting; rescanRequired drops it instead.
+    std::vector<FolderChange> folderChanges;
+    bool rescanRequired = false;
+};
+
+struct PreviewResult {
+    std::uint64_t generation = 0;
+    // False for the rows streamed while the collection is still running;
+    // totalCount then counts the matches found so far.
+    bool complete = true;
+    CollectResult collect;
+};
+
+// Runs preview collections on a background thread. Every request gets the
+// next generation number and cancels the job in flight; a request that is
+// superseded before it starts is dropped, with its folder changes carried
+// over. Only the results of the newest generation are ever handed out:
+// partial ones as rows stream in, then the complete one.
+// The DirectorySnapshot is owned here and only touched by the worker.
+class PreviewService {
+public:
+    // Invoked on the worker thread once a result can be taken. It should only
+    // wake the consumer, e.g. by posting a window message.
+    using ReadyCallback = std::function<void()>;
+
+    explicit PreviewService(ReadyCallback onReady = {});
+    ~PreviewService();
+
+    PreviewService(const PreviewService&) = delete;
+    PreviewService& operator=(const PreviewService&) = delete;
+
+    // Returns the generation assigned to the request. The cancellation
+    // token and progress callback of request.options are replaced by the
+    // service's own.
+    std::uint64_t Request(PreviewRequest request);
+
+    // Moves out the latest result of the newest request, partial or not.
+    // Returns false when nothing new arrived since the last call.
+    bool TakeResult(PreviewResult& result);
+
+    // Blocks until TakeResult succeeds or `timeout` passes.
+    bool WaitForResult(PreviewResult& result, std::chrono::milliseconds timeout);
+
+    // Generation of the newest request, 0 before the first one.
+    std::uint64_t GetGeneration() const;
+
+private:
+    void WorkerLoop();
+    void PublishProgress(std::uint64_t generation, const CollectProgress& progress);
+    void Publish(PreviewResult&& result);
+
+    ReadyCallback m_onReady;
+    DirectorySnapshot m_snapshot;
+    CancellationToken m_cancellation;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_resultReady;
+    std::optional<PreviewRequest> m_pending;
+    std::optional<PreviewResult> m_result;
+    std::uint64_t m_generation = 0;
+    bool m_stopping = false;
+
+    std::thread m_worker;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,1316 @@
+#include "RegexAutomaton.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace RenamerCore {
+namespace {
+
+using CodeUnit = std::uint32_t;
+
+constexpr CodeUnit kMaxCodeUnit = std::numeric_limits<std::make_unsigned_t<wchar_t>>::max();
+constexpr std::size_t kNoOffset = std::wstring_view::npos;
+constexpr int kUnbounded = -1;
+constexpr int kMaxRepeatCount = 1000;
+constexpr std::size_t kMaxProgramSize = 20000;
+constexpr std::size_t kMaxDfaStates = 4096;
+constexpr std::size_t kDirectClassCount = 256;
+
+CodeUnit ToCodeUnit(wchar_t ch) {
+    return static_cast<std::make_unsigned_t<wchar_t>>(ch);
+}
+
+bool IsWordChar(wchar_t ch) {
+    return (ch >= L'a' && ch <= L'z') || (ch >= L'A' && ch <= L'Z') || (ch >= L'0' && ch <= L'9') || ch == L'_';
+}
+
+struct CharRange {
+    CodeUnit first;
+    CodeUnit last;
+};
+
+void NormalizeRanges(std::vector<CharRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const CharRange& left, const CharRange& right) {
+        return left.first < right.first;
+    });
+
+    std::vector<CharRange> merged;
+    for (const CharRange& range : ranges) {
+        if (!merged.empty() && (range.first <= merged.back().last || range.first - merged.back().last == 1)) {
+            merged.back().last = std::max(merged.back().last, range.last);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    ranges = std::move(merged);
+}
+
+void AppendComplement(const std::vector<CharRange>& ranges, std::vector<CharRange>& output) {
+    CodeUnit next = 0;
+    for (const CharRange& range : ranges) {
+        if (range.first > next) {
+            output.push_back({ next, range.first - 1 });
+        }
+        if (range.last == kMaxCodeUnit) {
+            return;
+        }
+        next = range.last + 1;
+    }
+    output.push_back({ next, kMaxCodeUnit });
+}
+
+std::vector<CharRange> DigitRanges() {
+    return { { L'0', L'9' } };
+}
+
+std::vector<CharRange> WordRanges() {
+    return { { L'0', L'9' }, { L'A', L'Z' }, { L'_', L'_' }, { L'a', L'z' } };
+}
+
+std::vector<CharRange> SpaceRanges() {
+    return {
+        { 0x09, 0x0D }, { 0x20, 0x20 }, { 0xA0, 0xA0 }, { 0x1680, 0x1680 }, { 0x2000, 0x200A },
+        { 0x2028, 0x2029 }, { 0x202F, 0x202F }, { 0x205F, 0x205F }, { 0x3000, 0x3000 }, { 0xFEFF, 0xFEFF }
+    };
+}
+
+std::vector<CharRange> LineTerminatorRanges() {
+    return { { 0x0A, 0x0A }, { 0x0D, 0x0D }, { 0x2028, 0x2029 } };
+}
+
+struct CharClass {
+    std::vector<CharRange> ranges;
+    bool negated = false;
+
+    bool Contains(CodeUnit ch) const {
+        const auto next = std::upper_bound(ranges.begin(), ranges.end(), ch, [](CodeUnit value, const CharRange& range) {
+            return value < range.first;
+        });
+        const bool inside = next != ranges.begin() && ch <= std::prev(next)->last;
+        return inside != negated;
+    }
+};
+
+// Platform::GetLowerCaseTable, except that a character whose lowercase form
+// differs from it in \d, \w or \s membership is left as it is (U+0130 would
+// otherwise fold to "i"). Class escapes then give the same answer for the
+// folded character as for the original one, which is how std::wregex tests
+// them, so they are never folded themselves.
+const wchar_t* GetFoldTable() {
+    static const std::vector<wchar_t> table = []() {
+        const CharClass escapes[] = { { DigitRanges() }, { WordRanges() }, { SpaceRanges() } };
+        auto inSameEscapes = [&](CodeUnit left, CodeUnit right) {
+            return std::all_of(std::begin(escapes), std::end(escapes), [&](const CharClass& escape) {
+                return escape.Contains(left) == escape.Contains(right);
+            });
+        };
+
+        const wchar_t* lowerTable = Platform::GetLowerCaseTable();
+        std::vector<wchar_t> folded(lowerTable, lowerTable + 0x10000);
+        for (CodeUnit code = 0; code < folded.size(); ++code) {
+            if (!inSameEscapes(code, ToCodeUnit(folded[code]))) {
+                folded[code] = static_cast<wchar_t>(code);
+            }
+        }
+        return folded;
+    }();
+    return table.data();
+}
+
+enum class NodeType {
+    Empty,
+    Char,
+    Class,
+    Begin,
+    End,
+    WordBoundary,
+    NotWordBoundary,
+    Group,
+    Concat,
+    Alternate,
+    Repeat
+};
+
+struct Node {
+    NodeType type = NodeType::Empty;
+    CodeUnit value = 0;
+    int min = 0;
+    int max = 0;
+    bool greedy = true;
+    std::vector<std::unique_ptr<Node>> children;
+};
+
+std::unique_ptr<Node> MakeNode(NodeType type, CodeUnit value = 0) {
+    auto node = std::make_unique<Node>();
+    node->type = type;
+    node->value = value;
+    return node;
+}
+
+// Captures are numbered in pattern order, so the groups of a subtree form
+// the contiguous range [first, last]. Leaves `first` > `last` without groups.
+void FindGroupRange(const Node& node, CodeUnit& first, CodeUnit& last) {
+    if (node.type == NodeType::Group) {
+        first = std::min(first, node.value);
+        last = std::max(last, node.value);
+    }
+    for (const std::unique_ptr<Node>& child : node.children) {
+        FindGroupRange(*child, first, last);
+    }
+}
+
+// What a node tells about the literal text of its matches. An exact node
+// always matches `prefix` (== suffix == best); otherwise every match starts
+// with `prefix`, ends with `suffix` and contains `best`.
+struct LiteralInfo {
+    bool exact = false;
+    std::wstring prefix;
+    std::wstring suffix;
+    std::wstring best;
+};
+
+LiteralInfo ExactLiteral(std::wstring text) {
+    LiteralInfo info;
+    info.exact = true;
+    info.prefix = text;
+    info.suffix = text;
+    info.best = std::move(text);
+    return info;
+}
+
+const std::wstring& Longer(const std::wstring& left, const std::wstring& right) {
+    return right.size() > left.size() ? right : left;
+}
+
+LiteralInfo ConcatLiterals(const LiteralInfo& left, const LiteralInfo& right) {
+    if (left.exact && right.exact) {
+        return ExactLiteral(left.best + right.best);
+    }
+
+    LiteralInfo info;
+    info.prefix = left.exact ? left.best + right.prefix : left.prefix;
+    info.suffix = right.exact ? left.suffix + right.best : right.suffix;
+    info.best = Longer(Longer(left.best, right.best), left.suffix + right.prefix);
+    info.best = Longer(info.best, Longer(info.prefix, info.suffix));
+    return info;
+}
+
+// Zero-width assertions keep their neighbours adjacent, so they count as an
+// empty exact literal; classes and alternations end the literal runs.
+LiteralInfo AnalyzeLiterals(const Node& node) {
+    switch (node.type) {
+    case NodeType::Empty:
+    case NodeType::Begin:
+    case NodeType::End:
+    case NodeType::WordBoundary:
+    case NodeType::NotWordBoundary:
+        return ExactLiteral({});
+    case NodeType::Char:
+        return ExactLiteral(std::wstring(1, static_cast<wchar_t>(node.value)));
+    case NodeType::Group:
+        return AnalyzeLiterals(*node.children[0]);
+    case NodeType::Concat: {
+        LiteralInfo info = ExactLiteral({});
+        for (const std::unique_ptr<Node>& child : node.children) {
+            info = ConcatLiterals(info, AnalyzeLiterals(*child));
+        }
+        return info;
+    }
+    case NodeType::Repeat: {
+        if (node.min == 0) {
+            return {};
+        }
+        LiteralInfo info = AnalyzeLiterals(*node.children[0]);
+        if (node.max != 1) {
+            info.exact = false;
+        }
+        return info;
+    }
+    case NodeType::Class:
+    case NodeType::Alternate:
+        break;
+    }
+    return {};
+}
+
+// Recursive descent over the ECMAScript grammar. Anything outside the
+// supported subset, including invalid syntax, makes Parse return null; the
+// std::wregex fallback then either handles the pattern or reports the error.
+class Parser {
+public:
+    Parser(std::wstring_view pattern, const wchar_t* foldTable, std::vector<CharClass>& classes)
+        : m_pattern(pattern)
+        , m_foldTable(foldTable)
+        , m_classes(classes) {
+    }
+
+    std::unique_ptr<Node> Parse() {
+        std::unique_ptr<Node> root = ParseDisjunction();
+        if (m_failed || m_position != m_pattern.size()) {
+            return nullptr;
+        }
+        return root;
+    }
+
+    std::size_t GetGroupCount() const {
+        return m_captureCount + 1;
+    }
+
+private:
+    bool AtEnd() const {
+        return m_position >= m_pattern.size();
+    }
+
+    wchar_t Peek(std::size_t offset = 0) const {
+        return m_position + offset < m_pattern.size() ? m_pattern[m_position + offset] : L'\0';
+    }
+
+    bool Consume(wchar_t ch) {
+        if (AtEnd() || m_pattern[m_position] != ch) {
+            return false;
+        }
+        ++m_position;
+        return true;
+    }
+
+    std::unique_ptr<Node> Fail() {
+        m_failed = true;
+        return nullptr;
+    }
+
+    CodeUnit Fold(CodeUnit ch) const {
+        return m_foldTable && ch < 0x10000 ? ToCodeUnit(m_foldTable[ch]) : ch;
+    }
+
+    std::unique_ptr<Node> ParseDisjunction() {
+        std::unique_ptr<Node> first = ParseAlternative();
+        if (m_failed || AtEnd() || Peek() != L'|') {
+            return first;
+        }
+
+        auto node = MakeNode(NodeType::Alternate);
+        node->children.push_back(std::move(first));
+        while (Consume(L'|')) {
+            std::unique_ptr<Node> alternative = ParseAlternative();
+            if (m_failed) {
+                return nullptr;
+            }
+            node->children.push_back(std::move(alternative));
+        }
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseAlternative() {
+        auto node = MakeNode(NodeType::Concat);
+        while (!AtEnd() && Peek() != L'|' && Peek() != L')') {
+            std::unique_ptr<Node> term = ParseTerm();
+            if (m_failed) {
+                return nullptr;
+            }
+            node->children.push_back(std::move(term));
+        }
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseTerm() {
+        if (Consume(L'^')) {
+            return MakeNode(NodeType::Begin);
+        }
+        if (Consume(L'$')) {
+            return MakeNode(NodeType::End);
+        }
+        if (Peek() == L'\\' && (Peek(1) == L'b' || Peek(1) == L'B')) {
+            const bool boundary = Peek(1) == L'b';
+            m_position += 2;
+            return MakeNode(boundary ? NodeType::WordBoundary : NodeType::NotWordBoundary);
+        }
+
+        std::unique_ptr<Node> atom = ParseAtom();
+        if (m_failed) {
+            return nullptr;
+        }
+        return ParseQuantifier(std::move(atom));
+    }
+
+    bool ParseNumber(int& value) {
+        const std::size_t start = m_position;
+        value = 0;
+        while (!AtEnd() && Peek() >= L'0' && Peek() <= L'9') {
+            value = std::min(value * 10 + (Peek() - L'0'), kMaxRepeatCount + 1);
+            ++m_position;
+        }
+        return m_position != start;
+    }
+
+    std::unique_ptr<Node> ParseQuantifier(std::unique_ptr<Node> atom) {
+        int min = 0;
+        int max = 0;
+        if (Consume(L'*')) {
+            max = kUnbounded;
+        } else if (Consume(L'+')) {
+            min = 1;
+            max = kUnbounded;
+        } else if (Consume(L'?')) {
+            max = 1;
+        } else if (Consume(L'{')) {
+            if (!ParseNumber(min)) {
+                return Fail();
+            }
+            max = min;
+            if (Consume(L',')) {
+                max = kUnbounded;
+                if (Peek() != L'}' && !ParseNumber(max)) {
+                    return Fail();
+                }
+            }
+            if (!Consume(L'}')) {
+                return Fail();
+            }
+        } else {
+            return atom;
+        }
+
+        const bool greedy = !Consume(L'?');
+        if (min > kMaxRepeatCount || max > kMaxRepeatCount || (max != kUnbounded && max < min)) {
+            return Fail();
+        }
+        auto node = MakeNode(NodeType::Repeat);
+        node->min = min;
+        node->max = max;
+        node->greedy = greedy;
+        node->children.push_back(std::move(atom));
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseAtom() {
+        const wchar_t ch = Peek();
+        switch (ch) {
+        case L'.': {
+            ++m_position;
+            CharClass dot;
+            dot.ranges = LineTerminatorRanges();
+            dot.negated = true;
+            return AddClass(std::move(dot));
+        }
+        case L'(':
+            return ParseGroup();
+        case L'[':
+            return ParseClass();
+        case L'\\':
+            return ParseAtomEscape();
+        case L'*':
+        case L'+':
+        case L'?':
+        case L'{':
+        case L'}':
+        case L']':
+        case L')':
+        case L'|':
+            return Fail();
+        default:
+            ++m_position;
+            return MakeNode(NodeType::Char, Fold(ToCodeUnit(ch)));
+        }
+    }
+
+    std::unique_ptr<Node> ParseGroup() {
+        ++m_position;
+        bool capturing = true;
+        if (Consume(L'?')) {
+            if (!Consume(L':')) {
+                return Fail();
+            }
+            capturing = false;
+        }
+
+        const std::size_t index = capturing ? ++m_captureCount : 0;
+        std::unique_ptr<Node> inner = ParseDisjunction();
+        if (m_failed || !Consume(L')')) {
+            return Fail();
+        }
+        if (!capturing) {
+            return inner;
+        }
+
+        auto node = MakeNode(NodeType::Group, static_cast<CodeUnit>(index));
+        node->children.push_back(std::move(inner));
+        return node;
+    }
+
+    bool ParseHexDigits(std::size_t count, CodeUnit& value) {
+        value = 0;
+        for (std::size_t index = 0; index < count; ++index) {
+            const wchar_t digit = Peek();
+            CodeUnit nibble = 0;
+            if (digit >= L'0' && digit <= L'9') {
+                nibble = digit - L'0';
+            } else if (digit >= L'a' && digit <= L'f') {
+                nibble = digit - L'a' + 10;
+            } else if (digit >= L'A' && digit <= L'F') {
+                nibble = digit - L'A' + 10;
+            } else {
+                return false;
+            }
+            value = (value << 4) | nibble;
+            ++m_position;
+        }
+        return true;
+    }
+
+    // The escape letter has already been consumed.
+    bool ParseCharacterEscape(wchar_t letter, CodeUnit& value) {
+        switch (letter) {
+        case L't':
+            value = 0x09;
+            return true;
+        case L'n':
+            value = 0x0A;
+            return true;
+        case L'v':
+            value = 0x0B;
+            return true;
+        case L'f':
+            value = 0x0C;
+            return true;
+        case L'r':
+            value = 0x0D;
+            return true;
+        case L'c': {
+            const wchar_t control = Peek();
+            if (!((control >= L'a' && control <= L'z') || (control >= L'A' && control <= L'Z'))) {
+                return false;
+            }
+            ++m_position;
+            value = ToCodeUnit(control) % 32;
+            return true;
+        }
+        case L'x':
+            return ParseHexDigits(2, value);
+        case L'u':
+            return ParseHexDigits(4, value);
+        case L'0':
+            if (Peek() >= L'0' && Peek() <= L'9') {
+                return false;
+            }
+            value = 0;
+            return true;
+        default:
+            break;
+        }
+
+        if (std::wstring_view(L"^$\\.*+?()[]{}|/").find(letter) == std::wstring_view::npos) {
+            return false;
+        }
+        value = ToCodeUnit(letter);
+        return true;
+    }
+
+    // \d \w \s and their negations; false for any other letter.
+    static bool GetClassEscape(wchar_t letter, std::vector<CharRange>& ranges, bool& negated) {
+        switch (letter) {
+        case L'd':
+        case L'D':
+            ranges = DigitRanges();
+            break;
+        case L'w':
+        case L'W':
+            ranges = WordRanges();
+            break;
+        case L's':
+        case L'S':
+            ranges = SpaceRanges();
+            break;
+        default:
+            return false;
+        }
+        negated = letter == L'D' || letter == L'W' || letter == L'S';
+        return true;
+    }
+
+    std::unique_ptr<Node> ParseAtomEscape() {
+        ++m_position;
+        if (AtEnd()) {
+            return Fail();
+        }
+
+        const wchar_t letter = Peek();
+        ++m_position;
+
+        CharClass escaped;
+        std::vector<CharRange> escapeRanges;
+        if (GetClassEscape(letter, escapeRanges, escaped.negated)) {
+            return AddClass(std::move(escaped), std::move(escapeRanges));
+        }
+
+        CodeUnit value = 0;
+        if (!ParseCharacterEscape(letter, value)) {
+            return Fail();
+        }
+        return MakeNode(NodeType::Char, Fold(value));
+    }
+
+    // Parses one class atom. Class escapes add their ranges to `escapes` and
+    // leave `single` false, since they cannot be range endpoints.
+    bool ParseClassAtom(std::vector<CharRange>& escapes, CodeUnit& value, bool& single) {
+        single = false;
+        const wchar_t ch = Peek();
+        ++m_position;
+        if (ch != L'\\') {
+            value = ToCodeUnit(ch);
+            single = true;
+            return true;
+        }
+
+        if (AtEnd()) {
+            return false;
+        }
+        const wchar_t letter = Peek();
+        ++m_position;
+
+        std::vector<CharRange> escaped;
+        bool negated = false;
+        if (GetClassEscape(letter, escaped, negated)) {
+            if (negated) {
+                AppendComplement(escaped, escapes);
+            } else {
+                escapes.insert(escapes.end(), escaped.begin(), escaped.end());
+            }
+            return true;
+        }
+
+        if (letter == L'b') {
+            value = 0x08;
+        } else if (letter == L'-') {
+            value = L'-';
+        } else if (!ParseCharacterEscape(letter, value)) {
+            return false;
+        }
+        single = true;
+        return true;
+    }
+
+    std::unique_ptr<Node> ParseClass() {
+        ++m_position;
+        CharClass parsed;
+        std::vector<CharRange> escapes;
+        parsed.negated = Consume(L'^');
+
+        for (;;) {
+            if (AtEnd()) {
+                return Fail();
+            }
+            if (Consume(L']')) {
+                break;
+            }
+
+            CodeUnit first = 0;
+            bool single = false;
+            if (!ParseClassAtom(escapes, first, single)) {
+                return Fail();
+            }
+            if (Peek() == L'-' && Peek(1) != L']' && m_position + 1 < m_pattern.size()) {
+                ++m_position;
+                CodeUnit last = 0;
+                bool lastSingle = false;
+                if (!single || !ParseClassAtom(escapes, last, lastSingle) || !lastSingle || last < first) {
+                    return Fail();
+                }
+                parsed.ranges.push_back({ first, last });
+            } else if (single) {
+                parsed.ranges.push_back({ first, first });
+            }
+        }
+
+        if (parsed.ranges.empty() && escapes.empty()) {
+            return Fail();
+        }
+        return AddClass(std::move(parsed), std::move(escapes));
+    }
+
+    // With ignoreCase the members of every class are closed under folding,
+    // so testing the folded input character alone gives the case-insensitive
+    // answer. `escapes` are added unfolded (see GetFoldTable), and `negated`
+    // applies to the result.
+    std::unique_ptr<Node> AddClass(CharClass charClass, std::vector<CharRange> escapes = {}) {
+        NormalizeRanges(charClass.ranges);
+        if (m_foldTable) {
+            std::vector<CharRange> folded = charClass.ranges;
+            for (const CharRange& range : charClass.ranges) {
+                const CodeUnit last = std::min<CodeUnit>(range.last, 0xFFFF);
+                for (CodeUnit ch = range.first; ch <= last; ++ch) {
+                    const CodeUnit lowered = Fold(ch);
+                    if (lowered != ch) {
+                        folded.push_back({ lowered, lowered });
+                    }
+                }
+            }
+            charClass.ranges = std::move(folded);
+        }
+        charClass.ranges.insert(charClass.ranges.end(), escapes.begin(), escapes.end());
+        NormalizeRanges(charClass.ranges);
+
+        m_classes.push_back(std::move(charClass));
+        return MakeNode(NodeType::Class, static_cast<CodeUnit>(m_classes.size() - 1));
+    }
+
+    std::wstring_view m_pattern;
+    const wchar_t* m_foldTable;
+    std::vector<CharClass>& m_classes;
+    std::size_t m_position = 0;
+    std::size_t m_captureCount = 0;
+    bool m_failed = false;
+};
+
+enum class Op : std::uint8_t {
+    Char,
+    Class,
+    Split,
+    Jump,
+    Save,
+    ClearGroups,
+    AssertBegin,
+    AssertEnd,
+    WordBoundary,
+    NotWordBoundary,
+    Match
+};
+
+// Split prefers `target` over `alternative`; the order encodes greedy and
+// lazy quantifiers and the left-to-right preference of alternation.
+// ClearGroups resets the slots [value, target), as ECMAScript does for the
+// captures of a quantified atom at the start of every iteration.
+struct Instruction {
+    Op op = Op::Match;
+    CodeUnit value = 0;
+    std::uint32_t target = 0;
+    std::uint32_t alternative = 0;
+};
+
+class Compiler {
+public:
+    explicit Compiler(std::vector<Instruction>& program)
+        : m_program(program) {
+    }
+
+    bool Compile(const Node& root) {
+        Emit(Op::Save, 0);
+        CompileNode(root);
+        Emit(Op::Save, 1);
+        Emit(Op::Match);
+        return !m_overflow;
+    }
+
+private:
+    std::uint32_t Emit(Op op, CodeUnit value = 0) {
+        if (m_program.size() >= kMaxProgramSize) {
+            m_overflow = true;
+        }
+        Instruction instruction;
+        instruction.op = op;
+        instruction.value = value;
+        m_program.push_back(instruction);
+        return static_cast<std::uint32_t>(m_program.size() - 1);
+    }
+
+    std::uint32_t Next() const {
+        return static_cast<std::uint32_t>(m_program.size());
+    }
+
+    void SetSplit(std::uint32_t split, std::uint32_t body, std::uint32_t exit, bool greedy) {
+        m_program[split].target = greedy ? body : exit;
+        m_program[split].alternative = greedy ? exit : body;
+    }
+
+    void CompileNode(const Node& node) {
+        if (m_overflow) {
+            return;
+        }
+
+        switch (node.type) {
+        case NodeType::Empty:
+            break;
+        case NodeType::Char:
+            Emit(Op::Char, node.value);
+            break;
+        case NodeType::Class:
+            Emit(Op::Class, node.value);
+            break;
+        case NodeType::Begin:
+            Emit(Op::AssertBegin);
+            break;
+        case NodeType::End:
+            Emit(Op::AssertEnd);
+            break;
+        case NodeType::WordBoundary:
+            Emit(Op::WordBoundary);
+            break;
+        case NodeType::NotWordBoundary:
+            Emit(Op::NotWordBoundary);
+            break;
+        case NodeType::Group:
+            Emit(Op::Save, node.value * 2);
+            CompileNode(*node.children[0]);
+            Emit(Op::Save, node.value * 2 + 1);
+            break;
+        case NodeType::Concat:
+            for (const std::unique_ptr<Node>& child : node.children) {
+                CompileNode(*child);
+            }
+            break;
+        case NodeType::Alternate:
+            CompileAlternate(node);
+            break;
+        case NodeType::Repeat:
+            CompileRepeat(node);
+            break;
+        }
+    }
+
+    void CompileAlternate(const Node& node) {
+        std::vector<std::uint32_t> jumps;
+        for (std::size_t index = 0; index < node.children.size(); ++index) {
+            if (index + 1 == node.children.size()) {
+                CompileNode(*node.children[index]);
+                break;
+            }
+
+            const std::uint32_t split = Emit(Op::Split);
+            CompileNode(*node.children[index]);
+            jumps.push_back(Emit(Op::Jump));
+            if (m_overflow) {
+                return;
+            }
+            m_program[split].target = split + 1;
+            m_program[split].alternative = Next();
+        }
+
+        for (const std::uint32_t jump : jumps) {
+            m_program[jump].target = Next();
+        }
+    }
+
+    void CompileIteration(const Node& body) {
+        CodeUnit first = std::numeric_limits<CodeUnit>::max();
+        CodeUnit last = 0;
+        FindGroupRange(body, first, last);
+        if (first <= last) {
+            const std::uint32_t clear = Emit(Op::ClearGroups, first * 2);
+            m_program[clear].target = (last + 1) * 2;
+        }
+        CompileNode(body);
+    }
+
+    void CompileRepeat(const Node& node) {
+        const Node& body = *node.children[0];
+        for (int count = 0; count < node.min && !m_overflow; ++count) {
+            CompileIteration(body);
+        }
+
+        if (node.max == kUnbounded) {
+            const std::uint32_t split = Emit(Op::Split);
+            CompileIteration(body);
+            const std::uint32_t jump = Emit(Op::Jump);
+            if (m_overflow) {
+                return;
+            }
+            m_program[jump].target = split;
+            SetSplit(split, split + 1, Next(), node.greedy);
+            return;
+        }
+
+        std::vector<std::uint32_t> splits;
+        for (int count = node.min; count < node.max && !m_overflow; ++count) {
+            splits.push_back(Emit(Op::Split));
+            CompileIteration(body);
+        }
+        if (m_overflow) {
+            return;
+        }
+        for (const std::uint32_t split : splits) {
+            SetSplit(split, split + 1, Next(), node.greedy);
+        }
+    }
+
+    std::vector<Instruction>& m_program;
+    bool m_overflow = false;
+};
+
+class AutomatonRegexEngine final : public RegexEngine {
+public:
+    AutomatonRegexEngine(std::vector<Instruction> program, std::vector<CharClass> classes, std::size_t groupCount, const wchar_t* foldTable, std::wstring requiredLiteral)
+        : m_program(std::move(program))
+        , m_classes(std::move(classes))
+        , m_groupCount(groupCount)
+        , m_foldTable(foldTable)
+        , m_requiredLiteral(std::move(requiredLiteral)) {
+        m_dfaEnabled = std::none_of(m_program.begin(), m_program.end(), [](const Instruction& instruction) {
+            return instruction.op == Op::WordBoundary || instruction.op == Op::NotWordBoundary;
+        });
+        if (m_dfaEnabled) {
+            BuildInputClasses();
+        }
+    }
+
+    const char* GetName() const override {
+        return "automaton";
+    }
+
+    std::size_t GetGroupCount() const override {
+        return m_groupCount;
+    }
+
+    bool Search(std::wstring_view text, std::size_t start, const RegexSearchOptions& options, RegexGroups& groups) const override {
+        if (start > text.size()) {
+            return false;
+        }
+        if (!options.anchored && ScanDfa(text, start) == DfaResult::NoMatch) {
+            return false;
+        }
+        return RunPikeVm(text, start, options, groups);
+    }
+
+    bool IsMatch(std::wstring_view text) const override {
+        const DfaResult result = ScanDfa(text, 0);
+        if (result != DfaResult::GaveUp) {
+            return result == DfaResult::Match;
+        }
+        return RunPikeVm(text, 0, {}, m_matchGroups);
+    }
+
+    std::wstring_view GetRequiredLiteral() const override {
+        return m_requiredLiteral;
+    }
+
+    std::unique_ptr<RegexEngine> Clone() const override {
+        return std::make_unique<AutomatonRegexEngine>(*this);
+    }
+
+private:
+    enum class DfaResult {
+        NoMatch,
+        Match,
+        GaveUp
+    };
+
+    struct DfaState {
+        std::vector<std::uint32_t> consuming;
+        std::vector<std::uint32_t> endAssertions;
+        bool matches = false;
+        int acceptsAtEnd = -1;
+    };
+
+    struct ThreadList {
+        std::vector<std::uint32_t> marks;
+        std::uint32_t generation = 0;
+        std::vector<std::uint32_t> pcs;
+        std::vector<std::size_t> slots;
+
+        void Clear(std::size_t programSize) {
+            pcs.clear();
+            slots.clear();
+            if (marks.size() != programSize || ++generation == 0) {
+                marks.assign(programSize, 0);
+                generation = 1;
+            }
+        }
+
+        bool IsMarked(std::uint32_t pc) const {
+            return marks[pc] == generation;
+        }
+
+        void Mark(std::uint32_t pc) {
+            marks[pc] = generation;
+        }
+    };
+
+    struct AddFrame {
+        std::uint32_t pc;
+        std::size_t slot;
+        std::size_t savedValue;
+    };
+
+    CodeUnit Translate(wchar_t ch) const {
+        const CodeUnit code = ToCodeUnit(ch);
+        return m_foldTable && code < 0x10000 ? ToCodeUnit(m_foldTable[code]) : code;
+    }
+
+    bool Consumes(const Instruction& instruction, CodeUnit ch) const {
+        return instruction.op == Op::Char ? instruction.value == ch : m_classes[instruction.value].Contains(ch);
+    }
+
+    // Follows the non-consuming instructions from `pc` at `position` and
+    // appends the reachable consuming ones to `list` in priority order.
+    void AddThread(ThreadList& list, std::uint32_t pc, std::size_t position, std::wstring_view text, std::size_t* slots, bool notEmpty) const {
+        constexpr std::size_t kNoSlot = std::numeric_limits<std::size_t>::max();
+        const std::size_t slotCount = m_groupCount * 2;
+
+        m_stack.clear();
+        m_stack.push_back({ pc, kNoSlot, 0 });
+        while (!m_stack.empty()) {
+            const AddFrame frame = m_stack.back();
+            m_stack.pop_back();
+            if (frame.slot != kNoSlot) {
+                slots[frame.slot] = frame.savedValue;
+                continue;
+            }
+
+            std::uint32_t current = frame.pc;
+            bool follow = true;
+            while (follow && !list.IsMarked(current)) {
+                const Instruction& instruction = m_program[current];
+                if (instruction.op == Op::Match && notEmpty && slots[0] == position) {
+                    break;
+                }
+                list.Mark(current);
+
+                switch (instruction.op) {
+                case Op::Jump:
+                    current = instruction.target;
+                    break;
+                case Op::Split:
+                    m_stack.push_back({ instruction.alternative, kNoSlot, 0 });
+                    current = instruction.target;
+                    break;
+                case Op::Save:
+                    m_stack.push_back({ 0, instruction.value, slots[instruction.value] });
+                    slots[instruction.value] = position;
+                    ++current;
+                    break;
+                case Op::ClearGroups:
+                    for (std::size_t slot = instruction.value; slot < instruction.target; ++slot) {
+                        m_stack.push_back({ 0, slot, slots[slot] });
+                        slots[slot] = kNoOffset;
+                    }
+                    ++current;
+                    break;
+                case Op::AssertBegin:
+                    follow = position == 0;
+                    ++current;
+                    break;
+                case Op::AssertEnd:
+                    follow = position == text.size();
+                    ++current;
+                    break;
+                case Op::WordBoundary:
+                case Op::NotWordBoundary: {
+                    const bool before = position > 0 && IsWordChar(text[position - 1]);
+                    const bool after = position < text.size() && IsWordChar(text[position]);
+                    follow = (before != after) == (instruction.op == Op::WordBoundary);
+                    ++current;
+                    break;
+                }
+                case Op::Char:
+                case Op::Class:
+                case Op::Match:
+                    list.pcs.push_back(current);
+                    list.slots.insert(list.slots.end(), slots, slots + slotCount);
+                    follow = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool RunPikeVm(std::wstring_view text, std::size_t start, const RegexSearchOptions& options, RegexGroups& groups) const {
+        const std::size_t slotCount = m_groupCount * 2;
+        ThreadList* current = &m_lists[0];
+        ThreadList* next = &m_lists[1];
+        current->Clear(m_program.size());
+        m_slots.resize(slotCount);
+
+        bool matched = false;
+        for (std::size_t position = start;; ++position) {
+            if (!matched && (position == start || !options.anchored)) {
+                std::fill(m_slots.begin(), m_slots.end(), kNoOffset);
+                AddThread(*current, 0, position, text, m_slots.data(), options.notEmpty);
+            }
+            // Unanchored searches keep restarting even when no thread survives,
+            // since an assertion such as \b may only hold further on.
+            if (current->pcs.empty() && (matched || options.anchored)) {
+                break;
+            }
+
+            next->Clear(m_program.size());
+            const bool hasChar = position < text.size();
+            const CodeUnit ch = hasChar ? Translate(text[position]) : 0;
+            for (std::size_t index = 0; index < current->pcs.size(); ++index) {
+                const std::uint32_t pc = current->pcs[index];
+                std::size_t* threadSlots = current->slots.data() + index * slotCount;
+                if (m_program[pc].op == Op::Match) {
+                    // Lower-priority threads can only produce less preferred matches.
+                    groups.assign(threadSlots, threadSlots + slotCount);
+                    matched = true;
+                    break;
+                }
+                if (hasChar && Consumes(m_program[pc], ch)) {
+                    AddThread(*next, pc + 1, position + 1, text, threadSlots, options.notEmpty);
+                }
+            }
+
+            std::swap(current, next);
+            if (!hasChar) {
+                break;
+            }
+        }
+        return matched;
+    }
+
+    // The DFA alphabet: code units are grouped into intervals on which every
+    // Char and Class instruction gives the same answer.
+    void BuildInputClasses() {
+        std::vector<CodeUnit> boundaries { 0 };
+        auto addRange = [&boundaries](CodeUnit first, CodeUnit last) {
+            boundaries.push_back(first);
+            if (last != kMaxCodeUnit) {
+                boundaries.push_back(last + 1);
+            }
+        };
+        for (const Instruction& instruction : m_program) {
+            if (instruction.op == Op::Char) {
+                addRange(instruction.value, instruction.value);
+            } else if (instruction.op == Op::Class) {
+                for (const CharRange& range : m_classes[instruction.value].ranges) {
+                    addRange(range.first, range.last);
+                }
+            }
+        }
+        std::sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+        m_boundaries = std::move(boundaries);
+
+        for (std::size_t ch = 0; ch < kDirectClassCount; ++ch) {
+            m_directClasses[ch] = static_cast<std::uint32_t>(LookupInputClass(static_cast<CodeUnit>(ch)));
+        }
+    }
+
+    std::size_t LookupInputClass(CodeUnit ch) const {
+        return static_cast<std::size_t>(std::upper_bound(m_boundaries.begin(), m_boundaries.end(), ch) - m_boundaries.begin()) - 1;
+    }
+
+    std::size_t GetInputClass(CodeUnit ch) const {
+        return ch < kDirectClassCount ? m_directClasses[ch] : LookupInputClass(ch);
+    }
+
+    void Closure(const std::vector<std::uint32_t>& seeds, bool atStart, bool atEnd, DfaState& state) const {
+        ++m_closureGeneration;
+        if (m_closureMarks.size() != m_program.size() || m_closureGeneration == 0) {
+            m_closureMarks.assign(m_program.size(), 0);
+            m_closureGeneration = 1;
+        }
+
+        m_closureStack.assign(seeds.rbegin(), seeds.rend());
+        while (!m_closureStack.empty()) {
+            const std::uint32_t pc = m_closureStack.back();
+            m_closureStack.pop_back();
+            if (m_closureMarks[pc] == m_closureGeneration) {
+                continue;
+            }
+            m_closureMarks[pc] = m_closureGeneration;
+
+            const Instruction& instruction = m_program[pc];
+            switch (instruction.op) {
+            case Op::Char:
+            case Op::Class:
+                state.consuming.push_back(pc);
+                break;
+            case Op::Match:
+                state.matches = true;
+                break;
+            case Op::Jump:
+                m_closureStack.push_back(instruction.target);
+                break;
+            case Op::Split:
+                m_closureStack.push_back(instruction.alternative);
+                m_closureStack.push_back(instruction.target);
+                break;
+            case Op::Save:
+            case Op::ClearGroups:
+                m_closureStack.push_back(pc + 1);
+                break;
+            case Op::AssertBegin:
+                if (atStart) {
+                    m_closureStack.push_back(pc + 1);
+                }
+                break;
+            case Op::AssertEnd:
+                if (atEnd) {
+                    m_closureStack.push_back(pc + 1);
+                } else {
+                    state.endAssertions.push_back(pc);
+                }
+                break;
+            case Op::WordBoundary:
+            case Op::NotWordBoundary:
+                break;
+            }
+        }
+
+        std::sort(state.consuming.begin(), state.consuming.end());
+        std::sort(state.endAssertions.begin(), state.endAssertions.end());
+    }
+
+    // Returns the index of the state, adding it when it is new, or -1 when
+    // the cache is full.
+    int InternState(DfaState state) const {
+        std::vector<std::uint32_t> key = state.consuming;
+        key.push_back(std::numeric_limits<std::uint32_t>::max());
+        key.insert(key.end(), state.endAssertions.begin(), state.endAssertions.end());
+        key.push_back(state.matches ? 1 : 0);
+
+        const auto found = m_dfaIndex.find(key);
+        if (found != m_dfaIndex.end()) {
+            return found->second;
+        }
+        if (m_dfaStates.size() >= kMaxDfaStates) {
+            return -1;
+        }
+
+        const int index = static_cast<int>(m_dfaStates.size());
+        m_dfaStates.push_back(std::move(state));
+        m_dfaTransitions.resize(m_dfaStates.size() * m_boundaries.size(), -1);
+        m_dfaIndex.emplace(std::move(key), index);
+        return index;
+    }
+
+    int GetStartState(bool atStart) const {
+        int& cached = atStart ? m_dfaBeginState : m_dfaRestartState;
+        if (cached < 0) {
+            DfaState state;
+            Closure({ 0 }, atStart, false, state);
+            cached = InternState(std::move(state));
+        }
+        return cached;
+    }
+
+    // Scanning is unanchored: every step also restarts the program at the
+    // next position, so a state stands for all match attempts in flight.
+    int BuildTransition(int from, std::size_t inputClass) const {
+        const CodeUnit representative = m_boundaries[inputClass];
+        std::vector<std::uint32_t> seeds;
+        for (const std::uint32_t pc : m_dfaStates[static_cast<std::size_t>(from)].consuming) {
+            if (Consumes(m_program[pc], representative)) {
+                seeds.push_back(pc + 1);
+            }
+        }
+        seeds.push_back(0);
+
+        DfaState state;
+        Closure(seeds, false, false, state);
+        const int to = InternState(std::move(state));
+        if (to >= 0) {
+            m_dfaTransitions[static_cast<std::size_t>(from) * m_boundaries.size() + inputClass] = to;
+        }
+        return to;
+    }
+
+    bool AcceptsAtEnd(int index) const {
+        DfaState& state = m_dfaStates[static_cast<std::size_t>(index)];
+        if (state.acceptsAtEnd < 0) {
+            std::vector<std::uint32_t> seeds;
+            for (const std::uint32_t pc : state.endAssertions) {
+                seeds.push_back(pc + 1);
+            }
+            DfaState end;
+            Closure(seeds, false, true, end);
+            state.acceptsAtEnd = end.matches ? 1 : 0;
+        }
+        return state.acceptsAtEnd == 1;
+    }
+
+    DfaResult ScanDfa(std::wstring_view text, std::size_t start) const {
+        if (!m_dfaEnabled || start >= text.size()) {
+            return DfaResult::GaveUp;
+        }
+
+        int state = GetStartState(start == 0);
+        if (state < 0) {
+            return DfaResult::GaveUp;
+        }
+
+        const std::size_t classCount = m_boundaries.size();
+        for (std::size_t position = start; position < text.size(); ++position) {
+            if (m_dfaStates[static_cast<std::size_t>(state)].matches) {
+                return DfaResult::Match;
+            }
+
+            const std::size_t inputClass = GetInputClass(Translate(text[position]));
+            int next = m_dfaTransitions[static_cast<std::size_t>(state) * classCount + inputClass];
+            if (next < 0) {
+                next = BuildTransition(state, inputClass);
+                if (next < 0) {
+                    return DfaResult::GaveUp;
+                }
+            }
+            state = next;
+        }
+
+        if (m_dfaStates[static_cast<std::size_t>(state)].matches || AcceptsAtEnd(state)) {
+            return DfaResult::Match;
+        }
+        return DfaResult::NoMatch;
+    }
+
+    std::vector<Instruction> m_program;
+    std::vector<CharClass> m_classes;
+    std::size_t m_groupCount;
+    const wchar_t* m_foldTable;
+    std::wstring m_requiredLiteral;
+    bool m_dfaEnabled = false;
+    std::vector<CodeUnit> m_boundaries;
+    std::array<std::uint32_t, kDirectClassCount> m_directClasses {};
+
+    // Search scratch and the lazily built DFA.
+    mutable ThreadList m_lists[2];
+    mutable std::vector<std::size_t> m_slots;
+    mutable std::vector<AddFrame> m_stack;
+    mutable RegexGroups m_matchGroups;
+    mutable std::vector<DfaState> m_dfaStates;
+    mutable std::vector<int> m_dfaTransitions;
+    mutable std::map<std::vector<std::uint32_t>, int> m_dfaIndex;
+    mutable int m_dfaBeginState = -1;
+    mutable int m_dfaRestartState = -1;
+    mutable std::vector<std::uint32_t> m_closureMarks;
+    mutable std::uint32_t m_closureGeneration = 0;
+    mutable std::vector<std::uint32_t> m_closureStack;
+};
+
+} // namespace
+
+std::unique_ptr<RegexEngine> CompileAutomatonRegex(const std::wstring& pattern, bool ignoreCase) {
+    const wchar_t* foldTable = ignoreCase ? GetFoldTable() : nullptr;
+    std::vector<CharClass> classes;
+    Parser parser(pattern, foldTable, classes);
+    const std::unique_ptr<Node> root = parser.Parse();
+    if (!root) {
+        return nullptr;
+    }
+
+    std::vector<Instruction> program;
+    if (!Compiler(program).Compile(*root)) {
+        return nullptr;
+    }
+
+    // The prefilter searches text folded with the plain lowercase table.
+    std::wstring requiredLiteral = AnalyzeLiterals(*root).best;
+    if (ignoreCase) {
+        const wchar_t* lowerTable = Platform::GetLowerCaseTable();
+        for (wchar_t& ch : requiredLiteral) {
+            const CodeUnit code = ToCodeUnit(ch);
+            ch = code < 0x10000 ? lowerTable[code] : ch;
+        }
+    }
+
+    return std::make_unique<AutomatonRegexEngine>(std::move(program), std::move(classes), parser.GetGroupCount(), foldTable, std::move(requiredLiteral));
+}
+
+} // namespace RenamerCore
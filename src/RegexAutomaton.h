@@ -0,0 +1,18 @@
+#pragma once
+
+#include "RegexEngine.h"
+
+#include <memory>
+#include <string>
+
+namespace RenamerCore {
+
+// Linear-time engine: a lazily built DFA rejects names without a match and a
+// Pike VM extracts the groups of the names that have one. Covers literals,
+// ., classes, the \d \w \s escapes, groups, alternation, greedy and lazy
+// quantifiers and ^ $ \b \B. Returns null for anything else (backreferences,
+// lookaround, syntax that only Annex B accepts) so that the caller can fall
+// back to CompileStdRegex.
+std::unique_ptr<RegexEngine> CompileAutomatonRegex(const std::wstring& pattern, bool ignoreCase);
+
+} // namespace RenamerCore
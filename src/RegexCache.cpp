@@ -0,0 +1,68 @@
+#include "RegexCache.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace RenamerCore {
+
+RegexCache::Lease::Lease(RegexCache& cache, std::wstring pattern, bool ignoreCase, std::unique_ptr<RegexMatcher> matcher, bool cached)
+    : m_cache(&cache)
+    , m_pattern(std::move(pattern))
+    , m_ignoreCase(ignoreCase)
+    , m_matcher(std::move(matcher))
+    , m_cached(cached) {
+}
+
+RegexCache::Lease::~Lease() {
+    if (m_matcher) {
+        m_cache->Release(std::move(m_pattern), m_ignoreCase, std::move(m_matcher));
+    }
+}
+
+RegexCache::RegexCache(std::size_t capacity)
+    : m_capacity(std::max<std::size_t>(capacity, 1)) {
+}
+
+RegexCache::Lease RegexCache::Acquire(const std::wstring& pattern, bool ignoreCase) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto found = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& entry) {
+            return entry.ignoreCase == ignoreCase && entry.pattern == pattern;
+        });
+        if (found != m_entries.end()) {
+            std::unique_ptr<RegexMatcher> matcher = std::move(found->matcher);
+            m_entries.erase(found);
+            return Lease(*this, pattern, ignoreCase, std::move(matcher), true);
+        }
+    }
+
+    // Compiled outside the lock, so a slow pattern does not hold up others.
+    return Lease(*this, pattern, ignoreCase, std::make_unique<RegexMatcher>(pattern, ignoreCase), false);
+}
+
+void RegexCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+RegexCache& RegexCache::Shared() {
+    static RegexCache cache;
+    return cache;
+}
+
+void RegexCache::Release(std::wstring pattern, bool ignoreCase, std::unique_ptr<RegexMatcher> matcher) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const bool duplicate = std::any_of(m_entries.begin(), m_entries.end(), [&](const Entry& entry) {
+        return entry.ignoreCase == ignoreCase && entry.pattern == pattern;
+    });
+    if (duplicate) {
+        return;
+    }
+
+    if (m_entries.size() >= m_capacity) {
+        m_entries.pop_back();
+    }
+    m_entries.insert(m_entries.begin(), Entry { std::move(pattern), ignoreCase, std::move(matcher) });
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "RegexMatcher.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace RenamerCore {
+
+// The most recently used compiled patterns, keyed by pattern text and
+// ignoreCase, so that re-previews with an unchanged pattern skip compilation.
+// A matcher is checked out for exclusive use and goes back into the cache
+// when its lease ends; a pattern leased twice at once is compiled twice.
+class RegexCache {
+public:
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept = default;
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        const RegexMatcher& operator*() const { return *m_matcher; }
+        const RegexMatcher* operator->() const { return m_matcher.get(); }
+
+        // False when the pattern had to be compiled for this lease.
+        bool WasCached() const { return m_cached; }
+
+    private:
+        friend class RegexCache;
+
+        Lease(RegexCache& cache, std::wstring pattern, bool ignoreCase, std::unique_ptr<RegexMatcher> matcher, bool cached);
+
+        RegexCache* m_cache;
+        std::wstring m_pattern;
+        bool m_ignoreCase;
+        std::unique_ptr<RegexMatcher> m_matcher;
+        bool m_cached;
+    };
+
+    explicit RegexCache(std::size_t capacity = 8);
+
+    RegexCache(const RegexCache&) = delete;
+    RegexCache& operator=(const RegexCache&) = delete;
+
+    // Throws std::regex_error when the pattern does not compile.
+    Lease Acquire(const std::wstring& pattern, bool ignoreCase);
+
+    void Clear();
+
+    static RegexCache& Shared();
+
+private:
+    struct Entry {
+        std::wstring pattern;
+        bool ignoreCase;
+        std::unique_ptr<RegexMatcher> matcher;
+    };
+
+    void Release(std::wstring pattern, bool ignoreCase, std::unique_ptr<RegexMatcher> matcher);
+
+    std::size_t m_capacity;
+    std::mutex m_mutex;
+    // Most recently used first.
+    std::vector<Entry> m_entries;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,72 @@
+#include "RegexEngine.h"
+
+#include <regex>
+
+namespace RenamerCore {
+namespace {
+
+class StdRegexEngine final : public RegexEngine {
+public:
+    StdRegexEngine(const std::wstring& pattern, bool ignoreCase)
+        : m_regex(pattern, ignoreCase ? std::regex_constants::ECMAScript | std::regex_constants::icase : std::regex_constants::ECMAScript) {
+    }
+
+    const char* GetName() const override {
+        return "std::wregex";
+    }
+
+    std::size_t GetGroupCount() const override {
+        return m_regex.mark_count() + 1;
+    }
+
+    bool Search(std::wstring_view text, std::size_t start, const RegexSearchOptions& options, RegexGroups& groups) const override {
+        auto flags = std::regex_constants::match_default;
+        if (start > 0) {
+            flags |= std::regex_constants::match_prev_avail;
+        }
+        if (options.notEmpty) {
+            flags |= std::regex_constants::match_not_null;
+        }
+        if (options.anchored) {
+            flags |= std::regex_constants::match_continuous;
+        }
+
+        const wchar_t* const begin = text.data();
+        if (!std::regex_search(begin + start, begin + text.size(), m_match, m_regex, flags)) {
+            return false;
+        }
+
+        groups.assign(m_match.size() * 2, std::wstring_view::npos);
+        for (std::size_t index = 0; index < m_match.size(); ++index) {
+            if (m_match[index].matched) {
+                groups[index * 2] = static_cast<std::size_t>(m_match[index].first - begin);
+                groups[index * 2 + 1] = static_cast<std::size_t>(m_match[index].second - begin);
+            }
+        }
+        return true;
+    }
+
+    bool IsMatch(std::wstring_view text) const override {
+        return std::regex_search(text.data(), text.data() + text.size(), m_regex);
+    }
+
+    std::wstring_view GetRequiredLiteral() const override {
+        return {};
+    }
+
+    std::unique_ptr<RegexEngine> Clone() const override {
+        return std::make_unique<StdRegexEngine>(*this);
+    }
+
+private:
+    std::wregex m_regex;
+    mutable std::match_results<const wchar_t*> m_match;
+};
+
+} // namespace
+
+std::unique_ptr<RegexEngine> CompileStdRegex(const std::wstring& pattern, bool ignoreCase) {
+    return std::make_unique<StdRegexEngine>(pattern, ignoreCase);
+}
+
+} // namespace RenamerCore
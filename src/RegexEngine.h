@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RenamerCore {
+
+// Match offsets into the searched text: group n spans [groups[2n], groups[2n + 1]).
+// Groups that did not take part in the match hold npos.
+using RegexGroups = std::vector<std::size_t>;
+
+struct RegexSearchOptions {
+    // Reject empty matches.
+    bool notEmpty = false;
+    // Only accept a match that begins exactly at `start`.
+    bool anchored = false;
+};
+
+// A compiled ECMAScript pattern. Engines keep per-search scratch state, so a
+// compiled engine must not be used from several threads at once.
+class RegexEngine {
+public:
+    virtual ~RegexEngine() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // Number of groups including the whole match (group 0).
+    virtual std::size_t GetGroupCount() const = 0;
+
+    // Finds the leftmost match starting at or after `start`, with the same
+    // preference between alternatives and quantifiers as a backtracking
+    // ECMAScript engine. Characters before `start` are still visible to ^ and \b.
+    virtual bool Search(std::wstring_view text, std::size_t start, const RegexSearchOptions& options, RegexGroups& groups) const = 0;
+
+    // Whether the text contains a match at all. Engines may answer this
+    // without tracking where the match and its groups are.
+    virtual bool IsMatch(std::wstring_view text) const = 0;
+
+    // A substring every match contains, or empty when none is known. With
+    // ignoreCase it is folded through Platform::GetLowerCaseTable.
+    virtual std::wstring_view GetRequiredLiteral() const = 0;
+
+    // An independent copy, caches included, for use on another thread.
+    virtual std::unique_ptr<RegexEngine> Clone() const = 0;
+};
+
+// std::wregex backed engine, used for patterns the automaton does not cover.
+// Throws std::regex_error for invalid patterns.
+std::unique_ptr<RegexEngine> CompileStdRegex(const std::wstring& pattern, bool ignoreCase);
+
+} // namespace RenamerCore
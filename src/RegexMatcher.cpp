@@ -0,0 +1,80 @@
+#include "RegexMatcher.h"
+
+#include "RegexAutomaton.h"
+
+namespace RenamerCore {
+
+RegexMatcher::RegexMatcher(const std::wstring& pattern, bool ignoreCase)
+    : m_engine(CompileAutomatonRegex(pattern, ignoreCase)) {
+    if (!m_engine) {
+        m_engine = CompileStdRegex(pattern, ignoreCase);
+    }
+
+    const std::wstring_view literal = m_engine->GetRequiredLiteral();
+    if (!literal.empty()) {
+        if (ignoreCase) {
+            m_foldedPrefilter.emplace(literal);
+        } else {
+            m_prefilter.emplace(literal);
+        }
+    }
+}
+
+RegexMatcher::RegexMatcher(const RegexMatcher& other)
+    : m_engine(other.m_engine->Clone())
+    , m_prefilter(other.m_prefilter)
+    , m_foldedPrefilter(other.m_foldedPrefilter) {
+}
+
+bool RegexMatcher::PassesPrefilter(std::wstring_view text) const {
+    if (!m_prefilter && !m_foldedPrefilter) {
+        return true;
+    }
+
+    ++m_counters.checked;
+    const std::size_t found = m_prefilter ? m_prefilter->Find(text) : m_foldedPrefilter->Find(text);
+    if (found == std::wstring_view::npos) {
+        ++m_counters.rejected;
+        return false;
+    }
+    return true;
+}
+
+bool RegexMatcher::IsMatch(std::wstring_view text) const {
+    return PassesPrefilter(text) && m_engine->IsMatch(text);
+}
+
+// Walks the matches the way std::regex_iterator does: after an empty match
+// a non-empty match at the same position is tried first, then the search
+// resumes one character later.
+bool RegexMatcher::ReplaceAll(std::wstring_view text, const ReplacementTemplate& replacement, std::wstring& output) const {
+    if (!PassesPrefilter(text) || !m_engine->Search(text, 0, {}, m_groups)) {
+        return false;
+    }
+
+    output.clear();
+    std::size_t tail = 0;
+    for (;;) {
+        output.append(text, tail, m_groups[0] - tail);
+        replacement.Append(output, text, m_groups, tail);
+        tail = m_groups[1];
+
+        std::size_t next = m_groups[1];
+        if (m_groups[0] == m_groups[1]) {
+            if (next == text.size()) {
+                break;
+            }
+            if (m_engine->Search(text, next, { true, true }, m_groups)) {
+                continue;
+            }
+            ++next;
+        }
+        if (!m_engine->Search(text, next, {}, m_groups)) {
+            break;
+        }
+    }
+    output.append(text, tail, std::wstring_view::npos);
+    return true;
+}
+
+} // namespace RenamerCore
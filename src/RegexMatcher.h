@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CaseInsensitiveMatcher.h"
+#include "LiteralMatcher.h"
+#include "RegexEngine.h"
+#include "ReplacementTemplate.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace RenamerCore {
+
+// ECMAScript regex search-and-replace that walks the matches of a name once
+// and formats the output from them. Patterns run on the linear-time
+// automaton engine when it supports them and on std::wregex otherwise;
+// either way the output equals std::regex_replace with default flags, except
+// that captures inside quantified groups follow ECMAScript (reset on every
+// iteration) where some std::regex implementations keep stale values.
+// When the pattern has a required literal, names without it are rejected by
+// a literal scan before the engine runs.
+// Not safe to share between threads, since engines keep search scratch;
+// give every thread its own copy instead.
+class RegexMatcher {
+public:
+    struct PrefilterCounters {
+        std::size_t checked = 0;
+        std::size_t rejected = 0;
+    };
+
+    // Throws std::regex_error when the pattern does not compile.
+    RegexMatcher(const std::wstring& pattern, bool ignoreCase);
+
+    // Clones the compiled engine; the copy starts with zero counters.
+    RegexMatcher(const RegexMatcher& other);
+    RegexMatcher& operator=(const RegexMatcher&) = delete;
+
+    // Returns false, leaving `output` untouched, when nothing matches.
+    bool ReplaceAll(std::wstring_view text, const ReplacementTemplate& replacement, std::wstring& output) const;
+
+    // Same test as ReplaceAll without building any output.
+    bool IsMatch(std::wstring_view text) const;
+
+    // Running totals over the lifetime of the matcher; both stay at zero
+    // when the pattern has no required literal.
+    const PrefilterCounters& GetPrefilterCounters() const { return m_counters; }
+
+private:
+    bool PassesPrefilter(std::wstring_view text) const;
+
+    std::unique_ptr<RegexEngine> m_engine;
+    std::optional<LiteralMatcher> m_prefilter;
+    std::optional<CaseInsensitiveMatcher> m_foldedPrefilter;
+    mutable RegexGroups m_groups;
+    mutable PrefilterCounters m_counters;
+};
+
+} // namespace RenamerCore
@@ -0,0 +1,76 @@
+#include "RenamePlan.h"
+
+#include "Platform.h"
+
+namespace fs = std::filesystem;
+
+namespace RenamerCore {
+
+RenamePlan::RenamePlan(fs::path root)
+    : m_root(std::move(root))
+    , m_folders { std::wstring() }
+    , m_folderPaths { m_root }
+    , m_oldOffsets { 0 }
+    , m_newOffsets { 0 } {
+}
+
+std::uint32_t RenamePlan::AddFolder(const std::wstring& relativePath) {
+    if (relativePath.empty()) {
+        return 0;
+    }
+
+    m_folders.push_back(relativePath);
+    m_folderPaths.push_back(m_root / Platform::ToPath(relativePath));
+    return static_cast<std::uint32_t>(m_folders.size() - 1);
+}
+
+void RenamePlan::Add(std::uint32_t folder, std::wstring_view oldName, std::wstring_view newName, bool isDirectory) {
+    m_oldNames.append(oldName);
+    m_newNames.append(newName);
+    m_entryFolders.push_back(folder);
+    m_oldOffsets.push_back(static_cast<std::uint32_t>(m_oldNames.size()));
+    m_newOffsets.push_back(static_cast<std::uint32_t>(m_newNames.size()));
+    m_directoryFlags.push_back(isDirectory);
+}
+
+std::wstring RenamePlan::MakeDisplayName(std::size_t index, std::wstring_view name) const {
+    const std::wstring& folder = m_folders[m_entryFolders[index]];
+    if (folder.empty()) {
+        return std::wstring(name);
+    }
+
+    std::wstring displayName;
+    displayName.reserve(folder.size() + 1 + name.size());
+    displayName.append(folder);
+    displayName.push_back(static_cast<wchar_t>(fs::path::preferred_separator));
+    displayName.append(name);
+    return displayName;
+}
+
+std::wstring RenamePlan::GetOldDisplayName(std::size_t index) const {
+    return MakeDisplayName(index, GetOldName(index));
+}
+
+std::wstring RenamePlan::GetNewDisplayName(std::size_t index) const {
+    return MakeDisplayName(index, GetNewName(index));
+}
+
+fs::path RenamePlan::GetOldPath(std::size_t index) const {
+    return m_folderPaths[m_entryFolders[index]] / Platform::ToPath(std::wstring(GetOldName(index)));
+}
+
+fs::path RenamePlan::GetNewPath(std::size_t index) const {
+    return m_folderPaths[m_entryFolders[index]] / Platform::ToPath(std::wstring(GetNewName(index)));
+}
+
+RenameOperation RenamePlan::operator[](std::size_t index) const {
+    return {
+        GetOldPath(index),
+        GetNewPath(index),
+        GetOldDisplayName(index),
+        GetNewDisplayName(index),
+        IsDirectory(index)
+    };
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RenamerCore {
+
+struct RenameOperation {
+    std::filesystem::path oldPath;
+    std::filesystem::path newPath;
+    std::wstring oldName;
+    std::wstring newName;
+    bool isDirectory;
+};
+
+// Compact list of renames inside one folder tree. Every entry refers to its
+// folder by index, old and new names live in two shared buffers, and the
+// directory flags are bit-packed; full paths are only built on request.
+// operator[] materializes an entry as a RenameOperation, whose names are
+// relative to the root (the bare name for entries of the root itself).
+class RenamePlan {
+public:
+    explicit RenamePlan(std::filesystem::path root = {});
+
+    const std::filesystem::path& GetRoot() const { return m_root; }
+
+    // Registers a folder given relative to the root and returns its index.
+    // The root itself is always folder 0 and need not be added.
+    std::uint32_t AddFolder(const std::wstring& relativePath);
+    void Add(std::uint32_t folder, std::wstring_view oldName, std::wstring_view newName, bool isDirectory);
+
+    std::size_t size() const { return m_entryFolders.size(); }
+    bool empty() const { return m_entryFolders.empty(); }
+
+    std::uint32_t GetFolder(std::size_t index) const { return m_entryFolders[index]; }
+    std::size_t GetFolderCount() const { return m_folders.size(); }
+    const std::filesystem::path& GetFolderPath(std::uint32_t folder) const { return m_folderPaths[folder]; }
+
+    std::wstring_view GetOldName(std::size_t index) const {
+        return std::wstring_view(m_oldNames.data() + m_oldOffsets[index], m_oldOffsets[index + 1] - m_oldOffsets[index]);
+    }
+
+    std::wstring_view GetNewName(std::size_t index) const {
+        return std::wstring_view(m_newNames.data() + m_newOffsets[index], m_newOffsets[index + 1] - m_newOffsets[index]);
+    }
+
+    bool IsDirectory(std::size_t index) const { return m_directoryFlags[index]; }
+
+    std::wstring GetOldDisplayName(std::size_t index) const;
+    std::wstring GetNewDisplayName(std::size_t index) const;
+    std::filesystem::path GetOldPath(std::size_t index) const;
+    std::filesystem::path GetNewPath(std::size_t index) const;
+
+    RenameOperation operator[](std::size_t index) const;
+
+private:
+    std::wstring MakeDisplayName(std::size_t index, std::wstring_view name) const;
+
+    std::filesystem::path m_root;
+    std::vector<std::wstring> m_folders;
+    std::vector<std::filesystem::path> m_folderPaths;
+
+    std::wstring m_oldNames;
+    std::wstring m_newNames;
+    std::vector<std::uint32_t> m_entryFolders;
+    // One more element than there are entries: entry i spans
+    // [offsets[i], offsets[i + 1]) of m_oldNames or m_newNames.
+    std::vector<std::uint32_t> m_oldOffsets;
+    std::vector<std::uint32_t> m_newOffsets;
+    std::vector<bool> m_directoryFlags;
+};
+
+} // namespace RenamerCore
@@ -1,24 +1,33 @@
 #include "RenamerService.h"
 
-#include <windows.h>
-#include <objbase.h>
-#include <shlwapi.h>
+#include "CaseInsensitiveMatcher.h"
+#include "DirectoryTree.h"
+#include "LiteralMatcher.h"
+#include "RegexCache.h"
+#include "Platform.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <cwctype>
+#include <iterator>
+#include <map>
+#include <memory>
 #include <optional>
+#include <random>
 #include <regex>
 #include <set>
-
-#pragma comment(lib, "Shlwapi.lib")
+#include <type_traits>
+#include <utility>
 
 namespace fs = std::filesystem;
+namespace Platform = RenamerCore::Platform;
 
 namespace {
-struct EntryInfo {
-    std::wstring name;
-    bool isDirectory;
-};
+using Clock = std::chrono::steady_clock;
 
 std::wstring Trim(const std::wstring& text) {
     size_t begin = 0;
@@ -34,126 +43,335 @@ std::wstring Trim(const std::wstring& text) {
     return text.substr(begin, end - begin);
 }
 
-std::wstring ReplaceAll(const std::wstring& text, const std::wstring& pattern, const std::wstring& replacement) {
-    if (pattern.empty()) {
-        return text;
-    }
+// A staged entry: `index` into the plan and where it was moved to. The old
+// and target paths are rebuilt from the plan when they are needed.
+struct TempMapping {
+    std::size_t index;
+    fs::path tempPath;
+};
 
-    std::wstring result = text;
-    size_t position = 0;
+// Restores one level of a failed rename. Shallower levels must be rolled back
+// first so that the paths recorded here are reachable again.
+bool RollbackLevel(const RenamerCore::RenamePlan& plan, const std::vector<TempMapping>& tempMapping) {
+    bool succeeded = true;
+
+    for (auto it = tempMapping.rbegin(); it != tempMapping.rend(); ++it) {
+        const TempMapping& mapping = *it;
+        const fs::path targetPath = plan.GetNewPath(mapping.index);
+        std::error_code targetExistsEc;
+        const bool targetExists = fs::exists(targetPath, targetExistsEc);
+        std::error_code tempExistsEc;
+        const bool tempExists = fs::exists(mapping.tempPath, tempExistsEc);
+        if (targetExists && !tempExists) {
+            std::error_code rollbackEc;
+            Platform::RenamePath(targetPath, mapping.tempPath, rollbackEc);
+            if (rollbackEc) {
+                succeeded = false;
+            }
+        }
+    }
 
-    while ((position = result.find(pattern, position)) != std::wstring::npos) {
-        result.replace(position, pattern.size(), replacement);
-        position += replacement.size();
+    for (auto it = tempMapping.rbegin(); it != tempMapping.rend(); ++it) {
+        const TempMapping& mapping = *it;
+        std::error_code existsEc;
+        if (fs::exists(mapping.tempPath, existsEc)) {
+            std::error_code rollbackEc;
+            Platform::RenamePath(mapping.tempPath, plan.GetOldPath(mapping.index), rollbackEc);
+            if (rollbackEc) {
+                succeeded = false;
+            }
+        }
     }
 
-    return result;
+    return succeeded;
 }
 
-std::wstring ToLowerCopy(const std::wstring& text) {
-    if (text.empty()) {
-        return text;
-    }
-
-    const int required = LCMapStringEx(
-        LOCALE_NAME_INVARIANT,
-        LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING,
-        text.c_str(),
-        -1,
-        nullptr,
-        0,
-        nullptr,
-        nullptr,
-        0
-    );
-    if (required > 1) {
-        std::wstring lowered(static_cast<size_t>(required), L'\0');
-        const int written = LCMapStringEx(
-            LOCALE_NAME_INVARIANT,
-            LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING,
-            text.c_str(),
-            -1,
-            lowered.data(),
-            required,
-            nullptr,
-            nullptr,
-            0
-        );
-        if (written > 0) {
-            lowered.resize(static_cast<size_t>(written - 1));
-            return lowered;
+// Stop conditions shared by the workers of one collection: cancellation by
+// the caller and the regex deadline of CollectOptions::regexTimeLimit. They
+// are checked between names, since a single regex_search call of the
+// std::wregex fallback cannot be interrupted.
+struct MatchBudget {
+    const RenamerCore::CancellationToken* cancellation = nullptr;
+    bool hasDeadline = false;
+    Clock::time_point deadline;
+    std::atomic<bool> aborted { false };
+
+    template <bool kCheckDeadline>
+    bool Exhausted() {
+        if (aborted.load(std::memory_order_relaxed) || (cancellation && cancellation->IsCancelled())) {
+            return true;
+        }
+        if constexpr (kCheckDeadline) {
+            if (hasDeadline && Clock::now() >= deadline) {
+                aborted.store(true, std::memory_order_relaxed);
+                return true;
+            }
         }
+        return false;
     }
+};
 
-    std::wstring lowered = text;
-    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](wchar_t ch) {
-        return static_cast<wchar_t>(std::towlower(ch));
-    });
-    return lowered;
-}
+// Name transformations, one per rename mode. CollectOperations selects one
+// per call and instantiates its entry loop for it, so the loop carries no
+// mode dispatch. Each returns false when the entry is not part of the plan;
+// Matches() gives the same answer without building the new name.
+// kCanAbort marks the modes whose evaluation is bounded by a deadline.
+struct LiteralRename {
+    static constexpr bool kCanAbort = false;
+
+    const RenamerCore::LiteralMatcher& matcher;
+    std::wstring_view replacement;
 
-size_t FindCaseInsensitive(const std::wstring& text, const std::wstring& pattern, size_t start = 0) {
-    if (pattern.empty() || start >= text.size()) {
-        return std::wstring::npos;
+    bool operator()(std::wstring_view name, bool, std::wstring& newName) const {
+        return matcher.ReplaceAll(name, replacement, newName);
     }
 
-    const std::wstring lowerText = ToLowerCopy(text);
-    const std::wstring lowerPattern = ToLowerCopy(pattern);
-    return lowerText.find(lowerPattern, start);
-}
+    bool Matches(std::wstring_view name, bool) const {
+        return matcher.Find(name) != std::wstring_view::npos;
+    }
+};
+
+struct CaseInsensitiveRename {
+    static constexpr bool kCanAbort = false;
+
+    const RenamerCore::CaseInsensitiveMatcher& matcher;
+    std::wstring_view replacement;
+
+    bool operator()(std::wstring_view name, bool, std::wstring& newName) const {
+        return matcher.ReplaceAll(name, replacement, newName);
+    }
+
+    bool Matches(std::wstring_view name, bool) const {
+        return matcher.Find(name) != std::wstring_view::npos;
+    }
+};
+
+struct RegexRename {
+    static constexpr bool kCanAbort = true;
+
+    const RenamerCore::RegexMatcher& matcher;
+    const RenamerCore::ReplacementTemplate& replacement;
+    MatchBudget& budget;
+
+    bool operator()(std::wstring_view name, bool, std::wstring& newName) const {
+        // Some std::regex implementations give up on deep backtracking with
+        // error_complexity or error_stack; treat that as a timeout.
+        try {
+            return matcher.ReplaceAll(name, replacement, newName);
+        } catch (const std::regex_error&) {
+            budget.aborted.store(true, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    bool Matches(std::wstring_view name, bool) const {
+        try {
+            return matcher.IsMatch(name);
+        } catch (const std::regex_error&) {
+            budget.aborted.store(true, std::memory_order_relaxed);
+            return false;
+        }
+    }
+};
+
+struct PrefixRename {
+    static constexpr bool kCanAbort = false;
+
+    std::wstring_view prefix;
+
+    bool operator()(std::wstring_view name, bool, std::wstring& newName) const {
+        newName.assign(prefix);
+        newName.append(name);
+        return true;
+    }
+
+    bool Matches(std::wstring_view, bool) const {
+        return true;
+    }
+};
+
+// Files get the suffix before their extension, folders at the very end.
+struct SuffixRename {
+    static constexpr bool kCanAbort = false;
+
+    std::wstring_view suffix;
+
+    bool operator()(std::wstring_view name, bool isDirectory, std::wstring& newName) const {
+        if (isDirectory) {
+            newName.assign(name);
+            newName.append(suffix);
+            return true;
+        }
+
+        const fs::path filePath = Platform::ToPath(std::wstring(name));
+        newName = Platform::ToWide(filePath.stem());
+        newName.append(suffix);
+        newName.append(Platform::ToWide(filePath.extension()));
+        return true;
+    }
+
+    bool Matches(std::wstring_view, bool) const {
+        return true;
+    }
+};
+
+struct IdentityRename {
+    static constexpr bool kCanAbort = false;
+
+    bool operator()(std::wstring_view name, bool, std::wstring& newName) const {
+        newName.assign(name);
+        return true;
+    }
 
-std::wstring ReplaceAllCaseInsensitive(const std::wstring& text, const std::wstring& pattern, const std::wstring& replacement) {
-    if (pattern.empty()) {
-        return text;
+    bool Matches(std::wstring_view, bool) const {
+        return true;
     }
+};
+
+const RenamerCore::DirectoryEntry& GetDirectoryEntry(const RenamerCore::DirectoryEntry& entry) {
+    return entry;
+}
 
-    const std::wstring lowerText = ToLowerCopy(text);
-    const std::wstring lowerPattern = ToLowerCopy(pattern);
+const RenamerCore::DirectoryEntry& GetDirectoryEntry(const RenamerCore::DirectoryTreeEntry& entry) {
+    return entry.entry;
+}
 
-    std::wstring result;
-    result.reserve(text.size());
+// Runs `rename` over entries [begin, end) and reports the first `rowLimit`
+// matches in order. The entries after that are only tested, without
+// building new names; their matches go to onCounted and their number is
+// returned.
+template <typename Rename, typename Entry, typename OnMatch, typename OnCounted>
+std::size_t MatchRange(const Rename& rename,
+                       const std::vector<Entry>& entries,
+                       const RenamerCore::EntryArena& arena,
+                       std::size_t begin,
+                       std::size_t end,
+                       std::size_t rowLimit,
+                       MatchBudget& budget,
+                       OnMatch&& onMatch,
+                       OnCounted&& onCounted) {
+    std::size_t index = begin;
+    if (rowLimit > 0) {
+        std::wstring newName;
+        for (; index < end; ++index) {
+            if (budget.Exhausted<Rename::kCanAbort>()) {
+                return 0;
+            }
+            const RenamerCore::DirectoryEntry& entry = GetDirectoryEntry(entries[index]);
+            if (rename(arena.GetName(entry), entry.IsDirectory(), newName)) {
+                onMatch(index, newName);
+                if (--rowLimit == 0) {
+                    ++index;
+                    break;
+                }
+            }
+        }
+    }
 
-    size_t sourcePos = 0;
-    while (sourcePos < text.size()) {
-        const size_t foundPos = lowerText.find(lowerPattern, sourcePos);
-        if (foundPos == std::wstring::npos) {
-            result.append(text.substr(sourcePos));
+    std::size_t countOnly = 0;
+    for (; index < end; ++index) {
+        if (budget.Exhausted<Rename::kCanAbort>()) {
             break;
         }
+        const RenamerCore::DirectoryEntry& entry = GetDirectoryEntry(entries[index]);
+        if (rename.Matches(arena.GetName(entry), entry.IsDirectory())) {
+            onCounted(index);
+            ++countOnly;
+        }
+    }
+    return countOnly;
+}
 
-        result.append(text.substr(sourcePos, foundPos - sourcePos));
-        result.append(replacement);
-        sourcePos = foundPos + pattern.size();
+// More samples than this cost about as much as an exact count, so listings
+// no larger are not estimated at all.
+constexpr std::size_t kMaxEstimateSamples = 65536;
+
+// Tests entries picked uniformly at random, with replacement, until
+// `deadline` or kMaxEstimateSamples, and extrapolates the count to all
+// entries. The generator is seeded from the entry count, so repeated
+// previews of an unchanged listing draw the same entries.
+template <typename Rename, typename Entry>
+RenamerCore::MatchEstimate EstimateMatches(const Rename& rename,
+                                           const std::vector<Entry>& entries,
+                                           const RenamerCore::EntryArena& arena,
+                                           Clock::time_point deadline,
+                                           MatchBudget& budget) {
+    constexpr std::size_t kSamplesPerClockCheck = 256;
+    constexpr double kZ = 1.96;
+
+    RenamerCore::MatchEstimate estimate;
+    if (entries.empty()) {
+        return estimate;
     }
 
-    return result;
+    std::mt19937_64 random(entries.size());
+    std::uniform_int_distribution<std::size_t> pick(0, entries.size() - 1);
+    while (estimate.sampleCount < kMaxEstimateSamples && Clock::now() < deadline) {
+        for (std::size_t sample = 0; sample < kSamplesPerClockCheck; ++sample) {
+            if (budget.Exhausted<Rename::kCanAbort>()) {
+                return RenamerCore::MatchEstimate {};
+            }
+            const RenamerCore::DirectoryEntry& entry = GetDirectoryEntry(entries[pick(random)]);
+            ++estimate.sampleCount;
+            if (rename.Matches(arena.GetName(entry), entry.IsDirectory())) {
+                ++estimate.sampleMatches;
+            }
+        }
+    }
+
+    const double samples = static_cast<double>(estimate.sampleCount);
+    const double total = static_cast<double>(entries.size());
+    const double ratio = estimate.sampleMatches / samples;
+    const double z2 = kZ * kZ;
+    const double center = (ratio + z2 / (2.0 * samples)) / (1.0 + z2 / samples);
+    const double halfWidth = kZ * std::sqrt(ratio * (1.0 - ratio) / samples + z2 / (4.0 * samples * samples)) / (1.0 + z2 / samples);
+    estimate.count = static_cast<std::size_t>(std::llround(ratio * total));
+    estimate.low = static_cast<std::size_t>(std::floor((std::max)(0.0, center - halfWidth) * total));
+    estimate.high = static_cast<std::size_t>(std::ceil((std::min)(1.0, center + halfWidth) * total));
+    return estimate;
 }
 
-std::wstring PathKey(const fs::path& path) {
-    std::error_code absoluteEc;
-    const fs::path absolutePath = fs::absolute(path, absoluteEc);
-    std::wstring key = absoluteEc ? path.wstring() : absolutePath.lexically_normal().wstring();
-    return ToLowerCopy(key);
+// The matches of one entry range of a parallel collection. Only the rows the
+// plan still has room for are kept, since no range can contribute more;
+// matchCount covers the count-only rest as well, which is only recorded in
+// countedEntries for a PlanView.
+struct MatchChunk {
+    std::vector<std::uint32_t> entries;
+    std::vector<std::uint32_t> countedEntries;
+    std::vector<std::size_t> newNameEnds;
+    std::wstring newNames;
+    std::size_t matchCount = 0;
+};
+
+// Wraps a rename functor for PlanView, which outlives the collection, so
+// `state` owns everything the functor refers to.
+template <typename State, typename MakeRename>
+RenamerCore::PlanView::Rename BindRename(std::shared_ptr<State> state, MakeRename makeRename) {
+    return [state = std::move(state), makeRename](std::wstring_view name, bool isDirectory, std::wstring& newName) {
+        return makeRename(*state)(name, isDirectory, newName);
+    };
 }
 
-std::wstring MakeTempSuffix() {
-    GUID guid = {};
-    if (FAILED(CoCreateGuid(&guid))) {
-        return L".renamer_tmp_fallback_" + std::to_wstring(GetTickCount64());
+struct RegexViewState {
+    RegexViewState(const RenamerCore::RegexMatcher& regexMatcher, const RenamerCore::ReplacementTemplate& replacementTemplate)
+        : matcher(regexMatcher)
+        , replacement(replacementTemplate) {
     }
 
-    wchar_t guidBuffer[64] = {};
-    StringFromGUID2(guid, guidBuffer, 64);
+    RenamerCore::RegexMatcher matcher;
+    RenamerCore::ReplacementTemplate replacement;
+    MatchBudget budget;
+};
 
-    std::wstring token = guidBuffer;
-    token.erase(
-        std::remove_if(token.begin(), token.end(), [](wchar_t ch) {
-            return ch == L'{' || ch == L'}' || ch == L'-';
-        }),
-        token.end()
-    );
+// Also the leading range a streaming collection matches on the calling
+// thread before handing the rest to the pool.
+constexpr std::size_t kMinMatchChunkSize = 4096;
 
-    return L".renamer_tmp_" + token;
+std::size_t GetMatchChunkCount(std::size_t entryCount, std::size_t threshold, std::size_t threadCount) {
+    if (threshold == 0 || entryCount < threshold || threadCount < 2) {
+        return 1;
+    }
+    return (std::min)(threadCount, (std::max<std::size_t>)(1, entryCount / kMinMatchChunkSize));
 }
 
 } // namespace
@@ -168,169 +386,417 @@ CollectResult CollectOperations(
     bool ignoreCase,
     std::size_t maxOperations
 ) {
+    DirectorySnapshot snapshot;
+    return CollectOperations(snapshot, folderText, pattern, replacement, { useRegex, ignoreCase, false, maxOperations });
+}
+
+CollectResult CollectOperations(
+    DirectorySnapshot& snapshot,
+    const std::wstring& folderText,
+    const std::wstring& pattern,
+    const std::wstring& replacement,
+    bool useRegex,
+    bool ignoreCase,
+    std::size_t maxOperations
+) {
+    return CollectOperations(snapshot, folderText, pattern, replacement, { useRegex, ignoreCase, false, maxOperations });
+}
+
+CollectResult CollectOperations(
+    const std::wstring& folderText,
+    const std::wstring& pattern,
+    const std::wstring& replacement,
+    const CollectOptions& options
+) {
+    DirectorySnapshot snapshot;
+    return CollectOperations(snapshot, folderText, pattern, replacement, options);
+}
+
+CollectResult CollectOperations(
+    DirectorySnapshot& snapshot,
+    const std::wstring& folderText,
+    const std::wstring& pattern,
+    const std::wstring& replacement,
+    const CollectOptions& options
+) {
+    const Clock::time_point collectStart = Clock::now();
     CollectResult result;
     result.totalCount = 0;
 
     const std::wstring folder = Trim(folderText);
     const bool hasPattern = !pattern.empty();
+    const bool useRegex = options.useRegex;
+    const bool ignoreCase = options.ignoreCase;
 
     if (folder.empty()) {
         result.status = L"Укажите папку.";
         return result;
     }
 
-    fs::path folderPath(folder);
-    std::error_code ec;
-    if (!fs::exists(folderPath, ec) || !fs::is_directory(folderPath, ec)) {
-        result.status = L"Папка не найдена.";
-        return result;
+    const fs::path folderPath = Platform::ToPath(folder);
+    SnapshotStatus snapshotStatus = SnapshotStatus::Loaded;
+    if (options.recursive) {
+        if (Platform::GetEntryType(folderPath) != Platform::EntryType::Directory) {
+            result.status = L"Папка не найдена.";
+            return result;
+        }
+    } else {
+        snapshotStatus = snapshot.Refresh(folderPath, options.cancellation);
+        if (snapshotStatus == SnapshotStatus::NotFound) {
+            result.status = L"Папка не найдена.";
+            return result;
+        }
     }
 
-    std::optional<std::wregex> regexPattern;
+    std::optional<RegexCache::Lease> regexMatcher;
+    std::optional<ReplacementTemplate> replacementTemplate;
+    RegexMatcher::PrefilterCounters prefilterBefore;
     if (hasPattern && useRegex) {
+        const Clock::time_point compileStart = Clock::now();
         try {
-            auto flags = std::regex_constants::ECMAScript;
-            if (ignoreCase) {
-                flags |= std::regex_constants::icase;
-            }
-            regexPattern.emplace(pattern, flags);
+            regexMatcher.emplace(RegexCache::Shared().Acquire(pattern, ignoreCase));
         } catch (const std::regex_error&) {
             result.status = L"Ошибка regex: некорректный шаблон.";
             return result;
         }
+        result.stats.compileTime = Clock::now() - compileStart;
+        result.stats.patternCached = regexMatcher->WasCached();
+        prefilterBefore = (*regexMatcher)->GetPrefilterCounters();
+        replacementTemplate.emplace(replacement);
     }
 
-    std::vector<EntryInfo> entries;
-    for (fs::directory_iterator it(folderPath, ec), end; it != end; it.increment(ec)) {
-        if (ec) {
-            result.status = L"Не удалось прочитать содержимое папки.";
-            return result;
+    std::optional<LiteralMatcher> literalMatcher;
+    std::optional<CaseInsensitiveMatcher> caseInsensitiveMatcher;
+    if (hasPattern && !useRegex) {
+        if (ignoreCase) {
+            caseInsensitiveMatcher.emplace(pattern);
+        } else {
+            literalMatcher.emplace(pattern);
         }
+    }
 
-        std::error_code typeEc;
-        const bool isDirectory = it->is_directory(typeEc);
-        if (typeEc) {
-            continue;
+    DirectoryTree tree;
+    if (options.recursive) {
+        const Clock::time_point scanStart = Clock::now();
+        if (!ScanDirectoryTree(folderPath, ThreadPool::Shared(), tree, options.cancellation)) {
+            snapshotStatus = SnapshotStatus::ReadError;
         }
-
-        const bool isRegularFile = it->is_regular_file(typeEc);
-        if (typeEc) {
-            continue;
+        if (options.cancellation && options.cancellation->IsCancelled()) {
+            snapshotStatus = SnapshotStatus::Cancelled;
         }
+        result.stats.enumerateTime = Clock::now() - scanStart;
+        result.stats.entryCount = tree.entries.size();
+    }
 
-        if (!isRegularFile && !isDirectory) {
-            continue;
-        }
+    if (snapshotStatus == SnapshotStatus::Cancelled) {
+        result.cancelled = true;
+        result.status = L"Поиск отменен.";
+        return result;
+    }
 
-        entries.push_back({ it->path().filename().wstring(), isDirectory });
+    if (snapshotStatus == SnapshotStatus::ReadError) {
+        result.status = L"Не удалось прочитать содержимое папки.";
+        return result;
     }
 
-    std::sort(entries.begin(), entries.end(), [](const EntryInfo& left, const EntryInfo& right) {
-        const int compareResult = StrCmpLogicalW(left.name.c_str(), right.name.c_str());
-        if (compareResult != 0) {
-            return compareResult < 0;
+    if (!options.recursive) {
+        result.stats.entryCount = snapshot.GetEntries().size();
+        result.stats.snapshotReused = snapshotStatus == SnapshotStatus::Reused;
+        if (!result.stats.snapshotReused) {
+            result.stats.enumerateTime = snapshot.GetEnumerateTime();
+            result.stats.sortTime = snapshot.GetSortTime();
         }
-        return left.name < right.name;
-    });
+    }
+
+    const Clock::time_point matchStart = Clock::now();
+
+    const bool isPrefixMode = !hasPattern && !replacement.empty() && replacement.front() == L'<';
+    const bool isSuffixMode = !hasPattern && !replacement.empty() && replacement.front() == L'>';
+
+    MatchBudget budget;
+    budget.cancellation = options.cancellation;
+    budget.hasDeadline = options.regexTimeLimit.count() > 0;
+    budget.deadline = matchStart + options.regexTimeLimit;
 
-    auto addOperation = [&](const RenameOperation& operation) {
+    const std::size_t entryCount = options.recursive ? tree.entries.size() : snapshot.GetEntries().size();
+    auto matchRange = [&](const auto& rename, std::size_t begin, std::size_t end, std::size_t rowLimit, auto&& onMatch, auto&& onCounted) {
+        if (options.recursive) {
+            return MatchRange(rename, tree.entries, tree.arena, begin, end, rowLimit, budget, onMatch, onCounted);
+        }
+        return MatchRange(rename, snapshot.GetEntries(), snapshot.GetArena(), begin, end, rowLimit, budget, onMatch, onCounted);
+    };
+
+    result.operations = RenamePlan(folderPath);
+    constexpr std::uint32_t kNoFolder = UINT32_MAX;
+    std::vector<std::uint32_t> planFolders(tree.directories.size(), kNoFolder);
+    auto addOperation = [&](std::size_t index, std::wstring_view newName) {
+        if (options.maxOperations != 0 && result.operations.size() >= options.maxOperations) {
+            return;
+        }
+        if (options.recursive) {
+            const DirectoryTreeEntry& treeEntry = tree.entries[index];
+            std::uint32_t& folder = planFolders[treeEntry.parent];
+            if (folder == kNoFolder) {
+                folder = result.operations.AddFolder(tree.directories[treeEntry.parent]);
+            }
+            result.operations.Add(folder, tree.arena.GetName(treeEntry.entry), newName, treeEntry.entry.IsDirectory());
+        } else {
+            const DirectoryEntry& entry = snapshot.GetEntries()[index];
+            result.operations.Add(0, snapshot.GetArena().GetName(entry), newName, entry.IsDirectory());
+        }
+    };
+
+    std::size_t reportedRows = 0;
+    std::size_t nextBatchRows = (std::max<std::size_t>)(1, options.progressBatchSize);
+    auto reportProgress = [&](std::size_t scannedCount) {
+        const std::size_t rows = result.operations.size();
+        if (rows > 0 && result.stats.firstBatchTime.count() == 0) {
+            result.stats.firstBatchTime = Clock::now() - collectStart;
+        }
+        options.onProgress(CollectProgress { result.operations, reportedRows, result.totalCount, scannedCount, entryCount, result.stats.estimate });
+        reportedRows = rows;
+        nextBatchRows = (std::max)(nextBatchRows, rows * 2);
+    };
+    // Matches past maxOperations are only counted; see MatchRange.
+    auto getRowLimit = [&]() -> std::size_t {
+        if (options.maxOperations == 0) {
+            return SIZE_MAX;
+        }
+        return options.maxOperations - (std::min)(options.maxOperations, result.operations.size());
+    };
+    // Entry indices of every match, in order, for CollectResult::view.
+    std::vector<std::uint32_t> viewEntries;
+    auto addCounted = [&](std::size_t index) {
+        if (options.collectView) {
+            viewEntries.push_back(static_cast<std::uint32_t>(index));
+        }
+    };
+    auto addMatch = [&](std::size_t index, std::wstring_view newName) {
         ++result.totalCount;
-        if (maxOperations == 0 || result.operations.size() < maxOperations) {
-            result.operations.push_back(operation);
+        addCounted(index);
+        addOperation(index, newName);
+        if (options.onProgress) {
+            const std::size_t rows = result.operations.size();
+            if (rows > reportedRows && (rows >= nextBatchRows || rows == options.maxOperations)) {
+                reportProgress(index + 1);
+            }
         }
     };
 
-    if (hasPattern) {
-        for (const EntryInfo& entry : entries) {
-            const std::wstring& name = entry.name;
-            std::wstring newName;
+    // Large listings are split into one range per worker. Every range is
+    // matched on its own and the ranges are appended in entry order, so the
+    // plan and totalCount are the same as with a single pass.
+    ThreadPool& pool = ThreadPool::Shared();
+    const std::size_t chunkCount = GetMatchChunkCount(entryCount, options.parallelMatchThreshold, pool.GetThreadCount());
+    std::vector<std::unique_ptr<RegexMatcher>> regexCopies;
+    if (regexMatcher) {
+        for (std::size_t chunk = 1; chunk < chunkCount; ++chunk) {
+            regexCopies.push_back(std::make_unique<RegexMatcher>(**regexMatcher));
+        }
+    }
 
-            if (useRegex) {
-                if (!std::regex_search(name, *regexPattern)) {
-                    continue;
-                }
-                newName = std::regex_replace(name, *regexPattern, replacement);
+    const bool estimate = options.onProgress
+        && options.estimateTimeLimit.count() > 0
+        && entryCount > kMaxEstimateSamples
+        && entryCount >= options.estimateThreshold;
+
+    auto matchEntries = [&](auto makeRename) {
+        if (estimate) {
+            const Clock::time_point estimateStart = Clock::now();
+            const Clock::time_point estimateDeadline = estimateStart + options.estimateTimeLimit;
+            if (options.recursive) {
+                result.stats.estimate = EstimateMatches(makeRename(0), tree.entries, tree.arena, estimateDeadline, budget);
             } else {
-                if (ignoreCase) {
-                    if (FindCaseInsensitive(name, pattern) == std::wstring::npos) {
-                        continue;
-                    }
-                    newName = ReplaceAllCaseInsensitive(name, pattern, replacement);
-                } else {
-                    if (name.find(pattern) == std::wstring::npos) {
-                        continue;
-                    }
-                    newName = ReplaceAll(name, pattern, replacement);
-                }
+                result.stats.estimate = EstimateMatches(makeRename(0), snapshot.GetEntries(), snapshot.GetArena(), estimateDeadline, budget);
+            }
+            result.stats.estimateTime = Clock::now() - estimateStart;
+            // The samples went through chunk 0's matcher; only the full pass
+            // belongs in the prefilter statistics.
+            if (regexMatcher) {
+                prefilterBefore = (*regexMatcher)->GetPrefilterCounters();
+            }
+            if (result.stats.estimate.sampleCount > 0) {
+                reportProgress(0);
             }
-
-            addOperation({
-                folderPath / name,
-                folderPath / newName,
-                name,
-                newName,
-                entry.isDirectory
-            });
         }
 
-        result.status = L"Найдено совпадений: " + std::to_wstring(result.totalCount);
-        return result;
-    }
+        if (chunkCount < 2) {
+            result.totalCount += matchRange(makeRename(0), 0, entryCount, getRowLimit(), addMatch, addCounted);
+            return;
+        }
 
-    const bool isPrefixMode = !replacement.empty() && replacement.front() == L'<';
-    const bool isSuffixMode = !replacement.empty() && replacement.front() == L'>';
+        std::size_t leadEnd = 0;
+        if (options.onProgress) {
+            leadEnd = (std::min)(entryCount, kMinMatchChunkSize);
+            result.totalCount += matchRange(makeRename(0), 0, leadEnd, getRowLimit(), addMatch, addCounted);
+            if (result.operations.size() > reportedRows) {
+                reportProgress(leadEnd);
+            }
+        }
 
-    if (isPrefixMode || isSuffixMode) {
-        for (const EntryInfo& entry : entries) {
-            const std::wstring& name = entry.name;
-            std::wstring newName;
-            if (isPrefixMode) {
-                newName = replacement.substr(1) + name;
-            } else {
-                if (entry.isDirectory) {
-                    newName = name + replacement.substr(1);
-                } else {
-                    const fs::path filePath(name);
-                    const std::wstring stem = filePath.stem().wstring();
-                    const std::wstring ext = filePath.extension().wstring();
-                    newName = stem + replacement.substr(1) + ext;
+        const std::size_t restCount = entryCount - leadEnd;
+        const std::size_t chunkRowLimit = getRowLimit();
+        std::vector<MatchChunk> chunks(chunkCount);
+        ParallelFor(pool, chunkCount, [&](std::size_t chunkIndex) {
+            MatchChunk& chunk = chunks[chunkIndex];
+            const std::size_t begin = leadEnd + restCount * chunkIndex / chunkCount;
+            const std::size_t end = leadEnd + restCount * (chunkIndex + 1) / chunkCount;
+            auto onMatch = [&](std::size_t index, const std::wstring& newName) {
+                chunk.entries.push_back(static_cast<std::uint32_t>(index));
+                chunk.newNames.append(newName);
+                chunk.newNameEnds.push_back(chunk.newNames.size());
+            };
+            auto onCounted = [&](std::size_t index) {
+                if (options.collectView) {
+                    chunk.countedEntries.push_back(static_cast<std::uint32_t>(index));
                 }
+            };
+            chunk.matchCount = matchRange(makeRename(chunkIndex), begin, end, chunkRowLimit, onMatch, onCounted);
+            chunk.matchCount += chunk.entries.size();
+        });
+
+        for (const MatchChunk& chunk : chunks) {
+            result.totalCount += chunk.matchCount;
+            if (options.collectView) {
+                viewEntries.insert(viewEntries.end(), chunk.entries.begin(), chunk.entries.end());
+                viewEntries.insert(viewEntries.end(), chunk.countedEntries.begin(), chunk.countedEntries.end());
+            }
+            std::size_t nameBegin = 0;
+            for (std::size_t match = 0; match < chunk.entries.size(); ++match) {
+                const std::size_t nameEnd = chunk.newNameEnds[match];
+                addOperation(chunk.entries[match], std::wstring_view(chunk.newNames).substr(nameBegin, nameEnd - nameBegin));
+                nameBegin = nameEnd;
             }
+        }
+    };
 
-            addOperation({
-                folderPath / name,
-                folderPath / newName,
-                name,
-                newName,
-                entry.isDirectory
+    const std::wstring_view replacementTail = replacement.empty() ? std::wstring_view() : std::wstring_view(replacement).substr(1);
+    PlanView::Rename viewRename;
+    if (regexMatcher) {
+        matchEntries([&](std::size_t chunk) {
+            return RegexRename { chunk == 0 ? **regexMatcher : *regexCopies[chunk - 1], *replacementTemplate, budget };
+        });
+        if (options.collectView) {
+            viewRename = BindRename(std::make_shared<RegexViewState>(**regexMatcher, *replacementTemplate), [](RegexViewState& state) {
+                return RegexRename { state.matcher, state.replacement, state.budget };
+            });
+        }
+    } else if (caseInsensitiveMatcher) {
+        matchEntries([&](std::size_t) {
+            return CaseInsensitiveRename { *caseInsensitiveMatcher, replacement };
+        });
+        if (options.collectView) {
+            viewRename = BindRename(std::make_shared<std::pair<CaseInsensitiveMatcher, std::wstring>>(*caseInsensitiveMatcher, replacement), [](const auto& state) {
+                return CaseInsensitiveRename { state.first, state.second };
+            });
+        }
+    } else if (literalMatcher) {
+        matchEntries([&](std::size_t) {
+            return LiteralRename { *literalMatcher, replacement };
+        });
+        if (options.collectView) {
+            viewRename = BindRename(std::make_shared<std::pair<LiteralMatcher, std::wstring>>(*literalMatcher, replacement), [](const auto& state) {
+                return LiteralRename { state.first, state.second };
+            });
+        }
+    } else if (isPrefixMode) {
+        matchEntries([&](std::size_t) {
+            return PrefixRename { replacementTail };
+        });
+        if (options.collectView) {
+            viewRename = BindRename(std::make_shared<std::wstring>(replacementTail), [](const std::wstring& prefix) {
+                return PrefixRename { prefix };
+            });
+        }
+    } else if (isSuffixMode) {
+        matchEntries([&](std::size_t) {
+            return SuffixRename { replacementTail };
+        });
+        if (options.collectView) {
+            viewRename = BindRename(std::make_shared<std::wstring>(replacementTail), [](const std::wstring& suffix) {
+                return SuffixRename { suffix };
             });
         }
+    } else {
+        matchEntries([](std::size_t) {
+            return IdentityRename {};
+        });
+        if (options.collectView) {
+            viewRename = [](std::wstring_view name, bool isDirectory, std::wstring& newName) {
+                return IdentityRename {}(name, isDirectory, newName);
+            };
+        }
+    }
 
-        result.status = L"Паттерн пустой: массовый режим, элементов: " + std::to_wstring(result.totalCount);
+    if (options.cancellation && options.cancellation->IsCancelled()) {
+        result.operations = RenamePlan(folderPath);
+        result.totalCount = 0;
+        result.cancelled = true;
+        result.status = L"Поиск отменен.";
+        result.stats.matchTime = Clock::now() - matchStart;
         return result;
     }
 
-    for (const EntryInfo& entry : entries) {
-        const std::wstring& name = entry.name;
-        addOperation({
-            folderPath / name,
-            folderPath / name,
-            name,
-            name,
-            entry.isDirectory
-        });
+    if (budget.aborted.load()) {
+        result.operations = RenamePlan(folderPath);
+        result.totalCount = 0;
+        result.timedOut = true;
+        result.status = L"Ошибка regex: шаблон вычисляется слишком долго, поиск остановлен.";
+        result.stats.matchTime = Clock::now() - matchStart;
+        return result;
+    }
+
+    if (hasPattern) {
+        result.status = L"Найдено совпадений: " + std::to_wstring(result.totalCount);
+    } else if (isPrefixMode || isSuffixMode) {
+        result.status = L"Паттерн пустой: массовый режим, элементов: " + std::to_wstring(result.totalCount);
+    } else {
+        result.status = L"Паттерн пустой: показаны все элементы (" + std::to_wstring(result.totalCount) + L")";
+    }
+
+    if (tree.unreadableCount > 0) {
+        result.status += L" (не удалось прочитать подпапок: " + std::to_wstring(tree.unreadableCount) + L")";
+    }
+
+    if (options.collectView) {
+        result.view = std::make_shared<PlanView>(folderPath, std::move(viewRename));
+        std::vector<std::uint32_t> viewFolders(tree.directories.size(), kNoFolder);
+        for (const std::uint32_t index : viewEntries) {
+            if (options.recursive) {
+                const DirectoryTreeEntry& treeEntry = tree.entries[index];
+                std::uint32_t& folder = viewFolders[treeEntry.parent];
+                if (folder == kNoFolder) {
+                    folder = result.view->AddFolder(tree.directories[treeEntry.parent]);
+                }
+                result.view->Add(folder, tree.arena.GetName(treeEntry.entry), treeEntry.entry.IsDirectory());
+            } else {
+                const DirectoryEntry& entry = snapshot.GetEntries()[index];
+                result.view->Add(0, snapshot.GetArena().GetName(entry), entry.IsDirectory());
+            }
+        }
     }
 
-    result.status = L"Паттерн пустой: показаны все элементы (" + std::to_wstring(result.totalCount) + L")";
+    result.stats.matchTime = Clock::now() - matchStart;
+    if (regexMatcher) {
+        const RegexMatcher::PrefilterCounters& prefilterAfter = (*regexMatcher)->GetPrefilterCounters();
+        result.stats.prefilterChecked = prefilterAfter.checked - prefilterBefore.checked;
+        result.stats.prefilterRejected = prefilterAfter.rejected - prefilterBefore.rejected;
+        for (const std::unique_ptr<RegexMatcher>& copy : regexCopies) {
+            result.stats.prefilterChecked += copy->GetPrefilterCounters().checked;
+            result.stats.prefilterRejected += copy->GetPrefilterCounters().rejected;
+        }
+    }
     return result;
 }
 
-ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations) {
-    std::vector<RenameOperation> toRename;
-    toRename.reserve(operations.size());
-    for (const RenameOperation& operation : operations) {
-        if (operation.oldPath != operation.newPath) {
-            toRename.push_back(operation);
+ExecuteResult ExecuteRename(const RenamePlan& plan) {
+    const Clock::time_point validateStart = Clock::now();
+    ExecuteStats stats;
+
+    std::vector<std::size_t> toRename;
+    for (std::size_t index = 0; index < plan.size(); ++index) {
+        if (plan.GetOldName(index) != plan.GetNewName(index)) {
+            toRename.push_back(index);
         }
     }
 
@@ -339,23 +805,24 @@ ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations) {
     }
 
     std::set<std::wstring> uniqueNewPaths;
-    for (const RenameOperation& operation : toRename) {
-        const std::wstring key = PathKey(operation.newPath);
+    for (const std::size_t index : toRename) {
+        const std::wstring key = Platform::PathKey(plan.GetNewPath(index));
         if (!uniqueNewPaths.insert(key).second) {
             return { ExecuteStatus::Error, L"После замены есть дублирующиеся имена.", 0 };
         }
     }
 
     std::set<std::wstring> oldPathKeys;
-    for (const RenameOperation& operation : toRename) {
-        oldPathKeys.insert(PathKey(operation.oldPath));
+    for (const std::size_t index : toRename) {
+        oldPathKeys.insert(Platform::PathKey(plan.GetOldPath(index)));
     }
 
     std::vector<fs::path> conflicts;
-    for (const RenameOperation& operation : toRename) {
+    for (const std::size_t index : toRename) {
+        const fs::path newPath = plan.GetNewPath(index);
         std::error_code existsEc;
-        if (fs::exists(operation.newPath, existsEc) && oldPathKeys.find(PathKey(operation.newPath)) == oldPathKeys.end()) {
-            conflicts.push_back(operation.newPath);
+        if (fs::exists(newPath, existsEc) && oldPathKeys.find(Platform::PathKey(newPath)) == oldPathKeys.end()) {
+            conflicts.push_back(newPath);
         }
     }
 
@@ -363,7 +830,7 @@ ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations) {
         std::wstring message = L"Эти элементы уже существуют:\n";
         const size_t shown = (std::min)(conflicts.size(), static_cast<size_t>(10));
         for (size_t index = 0; index < shown; ++index) {
-            message += conflicts[index].filename().wstring();
+            message += Platform::ToWide(conflicts[index].filename());
             if (index + 1 < shown) {
                 message += L"\n";
             }
@@ -372,71 +839,79 @@ ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations) {
         return { ExecuteStatus::Error, message, 0 };
     }
 
-    struct TempMapping {
-        fs::path tempPath;
-        fs::path oldPath;
-        fs::path targetPath;
+    // Deeper entries are renamed first and each level is committed before
+    // the next one, so folders only move once their contents are done.
+    std::vector<std::size_t> folderDepths(plan.GetFolderCount());
+    for (std::uint32_t folder = 0; folder < folderDepths.size(); ++folder) {
+        const fs::path& folderPath = plan.GetFolderPath(folder);
+        folderDepths[folder] = static_cast<std::size_t>(std::distance(folderPath.begin(), folderPath.end()));
+    }
+    auto depthOf = [&plan, &folderDepths](std::size_t index) {
+        return folderDepths[plan.GetFolder(index)];
     };
+    std::stable_sort(toRename.begin(), toRename.end(), [&depthOf](std::size_t left, std::size_t right) {
+        return depthOf(left) > depthOf(right);
+    });
 
-    std::vector<TempMapping> tempMapping;
-    tempMapping.reserve(toRename.size());
+    const Clock::time_point stageStart = Clock::now();
+    stats.validateTime = stageStart - validateStart;
 
+    std::vector<std::vector<TempMapping>> levels;
     std::wstring errorMessage;
     bool failed = false;
 
-    for (const RenameOperation& operation : toRename) {
-        const fs::path tempPath = fs::path(operation.oldPath.wstring() + MakeTempSuffix());
-
-        std::error_code renameEc;
-        fs::rename(operation.oldPath, tempPath, renameEc);
-        if (renameEc) {
-            failed = true;
-            errorMessage = L"Не удалось переименовать временный файл: " + operation.oldName;
-            break;
+    for (std::size_t levelBegin = 0; levelBegin < toRename.size() && !failed;) {
+        std::size_t levelEnd = levelBegin;
+        while (levelEnd < toRename.size() && depthOf(toRename[levelEnd]) == depthOf(toRename[levelBegin])) {
+            ++levelEnd;
         }
 
-        tempMapping.push_back({ tempPath, operation.oldPath, operation.newPath });
-    }
+        const Clock::time_point levelStageStart = Clock::now();
+        levels.emplace_back();
+        std::vector<TempMapping>& tempMapping = levels.back();
+        tempMapping.reserve(levelEnd - levelBegin);
+
+        for (std::size_t position = levelBegin; position < levelEnd; ++position) {
+            const std::size_t index = toRename[position];
+            const fs::path oldPath = plan.GetOldPath(index);
+            fs::path tempPath = Platform::ToPath(Platform::ToWide(oldPath) + Platform::MakeTempSuffix());
 
-    if (!failed) {
-        for (const TempMapping& mapping : tempMapping) {
             std::error_code renameEc;
-            fs::rename(mapping.tempPath, mapping.targetPath, renameEc);
+            Platform::RenamePath(oldPath, tempPath, renameEc);
             if (renameEc) {
                 failed = true;
-                errorMessage = L"Не удалось завершить переименование: " + mapping.targetPath.filename().wstring();
+                errorMessage = L"Не удалось переименовать временный файл: " + plan.GetOldDisplayName(index);
                 break;
             }
-        }
-    }
 
-    if (failed) {
-        bool rollbackFailed = false;
+            tempMapping.push_back({ index, std::move(tempPath) });
+        }
 
-        for (auto it = tempMapping.rbegin(); it != tempMapping.rend(); ++it) {
-            const TempMapping& mapping = *it;
-            std::error_code targetExistsEc;
-            const bool targetExists = fs::exists(mapping.targetPath, targetExistsEc);
-            std::error_code tempExistsEc;
-            const bool tempExists = fs::exists(mapping.tempPath, tempExistsEc);
-            if (targetExists && !tempExists) {
-                std::error_code rollbackEc;
-                fs::rename(mapping.targetPath, mapping.tempPath, rollbackEc);
-                if (rollbackEc) {
-                    rollbackFailed = true;
+        const Clock::time_point levelCommitStart = Clock::now();
+        stats.stageTime += levelCommitStart - levelStageStart;
+
+        if (!failed) {
+            for (const TempMapping& mapping : tempMapping) {
+                const fs::path targetPath = plan.GetNewPath(mapping.index);
+                std::error_code renameEc;
+                Platform::RenamePath(mapping.tempPath, targetPath, renameEc);
+                if (renameEc) {
+                    failed = true;
+                    errorMessage = L"Не удалось завершить переименование: " + Platform::ToWide(targetPath.filename());
+                    break;
                 }
             }
         }
 
-        for (auto it = tempMapping.rbegin(); it != tempMapping.rend(); ++it) {
-            const TempMapping& mapping = *it;
-            std::error_code existsEc;
-            if (fs::exists(mapping.tempPath, existsEc)) {
-                std::error_code rollbackEc;
-                fs::rename(mapping.tempPath, mapping.oldPath, rollbackEc);
-                if (rollbackEc) {
-                    rollbackFailed = true;
-                }
+        stats.commitTime += Clock::now() - levelCommitStart;
+        levelBegin = levelEnd;
+    }
+
+    if (failed) {
+        bool rollbackFailed = false;
+        for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+            if (!RollbackLevel(plan, *it)) {
+                rollbackFailed = true;
             }
         }
 
@@ -444,10 +919,31 @@ ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations) {
             errorMessage += L" Rollback was only partially completed.";
         }
 
-        return { ExecuteStatus::Error, errorMessage, 0 };
+        return { ExecuteStatus::Error, errorMessage, 0, stats };
+    }
+
+    return { ExecuteStatus::Success, L"", toRename.size(), stats };
+}
+
+ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations) {
+    RenamePlan plan;
+    std::map<std::wstring, std::uint32_t> folders;
+    for (const RenameOperation& operation : operations) {
+        const std::wstring folder = Platform::ToWide(operation.oldPath.parent_path());
+        auto it = folders.find(folder);
+        if (it == folders.end()) {
+            it = folders.emplace(folder, plan.AddFolder(folder)).first;
+        }
+
+        plan.Add(
+            it->second,
+            Platform::ToWide(operation.oldPath.filename()),
+            Platform::ToWide(operation.newPath.filename()),
+            operation.isDirectory
+        );
     }
 
-    return { ExecuteStatus::Success, L"", toRename.size() };
+    return ExecuteRename(plan);
 }
 
 } // namespace RenamerCore
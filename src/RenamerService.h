@@ -1,24 +1,65 @@
 #pragma once
 
+#include "CancellationToken.h"
+#include "DirectorySnapshot.h"
+#include "PlanView.h"
+#include "RenamePlan.h"
+
+#include <chrono>
 #include <cstddef>
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace RenamerCore {
 
-struct RenameOperation {
-    std::filesystem::path oldPath;
-    std::filesystem::path newPath;
-    std::wstring oldName;
-    std::wstring newName;
-    bool isDirectory;
+// Match count of a whole listing extrapolated from a random sample, with a
+// 95% (Wilson score) confidence interval. sampleCount is 0 when none was made.
+struct MatchEstimate {
+    std::size_t sampleCount = 0;
+    std::size_t sampleMatches = 0;
+    std::size_t count = 0;
+    std::size_t low = 0;
+    std::size_t high = 0;
+};
+
+struct CollectStats {
+    std::size_t entryCount = 0;
+    std::chrono::nanoseconds enumerateTime { 0 };
+    std::chrono::nanoseconds sortTime { 0 };
+    std::chrono::nanoseconds matchTime { 0 };
+    std::chrono::nanoseconds compileTime { 0 };
+    bool snapshotReused = false;
+    // The regex came from RegexCache::Shared() instead of being compiled.
+    bool patternCached = false;
+    // Names the regex prefilter scanned and those it rejected without
+    // running the regex engine.
+    std::size_t prefilterChecked = 0;
+    std::size_t prefilterRejected = 0;
+    // From the call to the first CollectOptions::onProgress batch; zero when
+    // the collection finished before any batch was reported.
+    std::chrono::nanoseconds firstBatchTime { 0 };
+    // See CollectOptions::estimateTimeLimit; the exact count is totalCount.
+    MatchEstimate estimate;
+    std::chrono::nanoseconds estimateTime { 0 };
 };
 
 struct CollectResult {
-    std::vector<RenameOperation> operations;
+    // At most maxOperations entries; totalCount counts every match.
+    RenamePlan operations;
     std::wstring status;
     std::size_t totalCount;
+    CollectStats stats;
+    // Regex evaluation ran out of CollectOptions::regexTimeLimit; the result
+    // then holds no operations.
+    bool timedOut = false;
+    // CollectOptions::cancellation was triggered; no operations either.
+    bool cancelled = false;
+    // Every match, not limited by maxOperations, when
+    // CollectOptions::collectView is set and the collection completed.
+    std::shared_ptr<PlanView> view;
 };
 
 enum class ExecuteStatus {
@@ -27,10 +68,72 @@ enum class ExecuteStatus {
     Error
 };
 
+struct ExecuteStats {
+    std::chrono::nanoseconds validateTime { 0 };
+    std::chrono::nanoseconds stageTime { 0 };
+    std::chrono::nanoseconds commitTime { 0 };
+};
+
 struct ExecuteResult {
     ExecuteStatus status;
     std::wstring message;
     std::size_t renamedCount;
+    ExecuteStats stats {};
+};
+
+// Rows of a collection that is still running, see CollectOptions::onProgress.
+struct CollectProgress {
+    // Always a prefix of the final plan, so rows never move once reported.
+    // Those from firstNew on were not part of the previous batch.
+    const RenamePlan& operations;
+    std::size_t firstNew;
+    // Matches among the first scannedCount of entryCount entries; the final
+    // totalCount is only known when the collection returns.
+    std::size_t matchCount;
+    std::size_t scannedCount;
+    std::size_t entryCount;
+    const MatchEstimate& estimate;
+};
+
+using CollectProgressCallback = std::function<void(const CollectProgress& progress)>;
+
+struct CollectOptions {
+    static constexpr std::size_t DEFAULT_PARALLEL_MATCH_THRESHOLD = 20000;
+    static constexpr std::size_t DEFAULT_PROGRESS_BATCH_SIZE = 50;
+    static constexpr std::size_t DEFAULT_ESTIMATE_THRESHOLD = 100000;
+
+    bool useRegex = false;
+    bool ignoreCase = false;
+    // Also matches entries of every subfolder. Names in the result are then
+    // relative to the selected folder, while the pattern is applied to the
+    // last component only.
+    bool recursive = false;
+    std::size_t maxOperations = 0;
+    // Wall-clock budget for evaluating the regex over all names, 0 for none.
+    // Meant for the interactive preview; renaming should run unbounded.
+    std::chrono::milliseconds regexTimeLimit { 0 };
+    // Entries from which names are matched on the shared pool, 0 = never.
+    std::size_t parallelMatchThreshold = DEFAULT_PARALLEL_MATCH_THRESHOLD;
+    // Polled while enumerating and between names; once set the collection
+    // stops and returns a result with `cancelled` set.
+    const CancellationToken* cancellation = nullptr;
+    // Streams rows while matching: called on the collecting thread once
+    // progressBatchSize rows are known or the plan reaches maxOperations,
+    // and again each time the row count doubles. Large listings match a
+    // leading range on the calling thread first and report it before the
+    // rest goes to the pool. Rows found after the last batch only appear in
+    // the returned result.
+    CollectProgressCallback onProgress {};
+    std::size_t progressBatchSize = DEFAULT_PROGRESS_BATCH_SIZE;
+    // With onProgress set and at least estimateThreshold entries, random
+    // entries are matched for up to this long before the full pass, and the
+    // extrapolated count is reported in a batch of its own. 0 disables it.
+    // Listings no larger than the sample cap (65536) are never estimated.
+    std::chrono::milliseconds estimateTimeLimit { 0 };
+    std::size_t estimateThreshold = DEFAULT_ESTIMATE_THRESHOLD;
+    // Also fills CollectResult::view. Matches past maxOperations are then
+    // recorded as well, still without building their new names.
+    bool collectView = false;
 };
 
 CollectResult CollectOperations(
@@ -42,6 +145,39 @@ CollectResult CollectOperations(
     std::size_t maxOperations = 0
 );
 
+// Same as above, but enumerates through `snapshot`, which is reused as long as
+// the folder has not changed since the previous call.
+CollectResult CollectOperations(
+    DirectorySnapshot& snapshot,
+    const std::wstring& folderText,
+    const std::wstring& pattern,
+    const std::wstring& replacement,
+    bool useRegex,
+    bool ignoreCase,
+    std::size_t maxOperations = 0
+);
+
+CollectResult CollectOperations(
+    const std::wstring& folderText,
+    const std::wstring& pattern,
+    const std::wstring& replacement,
+    const CollectOptions& options
+);
+
+// Recursive collections do not use `snapshot`; the tree is scanned anew.
+CollectResult CollectOperations(
+    DirectorySnapshot& snapshot,
+    const std::wstring& folderText,
+    const std::wstring& pattern,
+    const std::wstring& replacement,
+    const CollectOptions& options
+);
+
+// Entries inside folders that are renamed as well are handled first, so
+// operations may address them through the old folder names.
+ExecuteResult ExecuteRename(const RenamePlan& plan);
+
+// Converts to a plan first; every operation must keep its parent folder.
 ExecuteResult ExecuteRename(const std::vector<RenameOperation>& operations);
 
 } // namespace RenamerCore
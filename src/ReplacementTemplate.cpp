@@ -0,0 +1,85 @@
+#include "ReplacementTemplate.h"
+
+namespace RenamerCore {
+
+ReplacementTemplate::ReplacementTemplate(std::wstring_view replacement) {
+    std::size_t position = 0;
+    for (;;) {
+        const std::size_t dollar = replacement.find(L'$', position);
+        if (dollar == std::wstring_view::npos) {
+            break;
+        }
+        AddLiteral(replacement.substr(position, dollar - position));
+        position = dollar + 1;
+
+        if (position == replacement.size()) {
+            AddLiteral(L"$");
+            continue;
+        }
+
+        const wchar_t ch = replacement[position];
+        if (ch == L'$') {
+            AddLiteral(L"$");
+            ++position;
+        } else if (ch == L'&') {
+            m_pieces.push_back({ PieceType::Group, 0, 0 });
+            ++position;
+        } else if (ch == L'`') {
+            m_pieces.push_back({ PieceType::Prefix, 0, 0 });
+            ++position;
+        } else if (ch == L'\'') {
+            m_pieces.push_back({ PieceType::Suffix, 0, 0 });
+            ++position;
+        } else if (ch >= L'0' && ch <= L'9') {
+            std::size_t number = static_cast<std::size_t>(ch - L'0');
+            ++position;
+            if (position < replacement.size() && replacement[position] >= L'0' && replacement[position] <= L'9') {
+                number = number * 10 + static_cast<std::size_t>(replacement[position] - L'0');
+                ++position;
+            }
+            m_pieces.push_back({ PieceType::Group, number, 0 });
+        } else {
+            AddLiteral(L"$");
+        }
+    }
+    AddLiteral(replacement.substr(position));
+}
+
+void ReplacementTemplate::AddLiteral(std::wstring_view literal) {
+    if (literal.empty()) {
+        return;
+    }
+
+    // Adjacent literals, such as the text around "$$", share one piece.
+    if (!m_pieces.empty() && m_pieces.back().type == PieceType::Literal) {
+        m_pieces.back().size += literal.size();
+    } else {
+        m_pieces.push_back({ PieceType::Literal, m_literals.size(), literal.size() });
+    }
+    m_literals.append(literal);
+}
+
+void ReplacementTemplate::Append(std::wstring& output, std::wstring_view text, const RegexGroups& groups, std::size_t prefixBegin) const {
+    const std::size_t groupCount = groups.size() / 2;
+    for (const Piece& piece : m_pieces) {
+        switch (piece.type) {
+        case PieceType::Literal:
+            output.append(m_literals, piece.offset, piece.size);
+            break;
+        case PieceType::Group:
+            if (piece.offset < groupCount && groups[piece.offset * 2] != std::wstring_view::npos) {
+                const std::size_t begin = groups[piece.offset * 2];
+                output.append(text, begin, groups[piece.offset * 2 + 1] - begin);
+            }
+            break;
+        case PieceType::Prefix:
+            output.append(text, prefixBegin, groups[0] - prefixBegin);
+            break;
+        case PieceType::Suffix:
+            output.append(text, groups[1], std::wstring_view::npos);
+            break;
+        }
+    }
+}
+
+} // namespace RenamerCore
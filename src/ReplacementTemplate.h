@@ -0,0 +1,46 @@
+#pragma once
+
+#include "RegexEngine.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RenamerCore {
+
+// A regex replacement string parsed once into literal runs and references,
+// following the ECMAScript format rules of match_results::format: $$, $&,
+// $` (text since the previous match), $' and one or two digit group numbers.
+class ReplacementTemplate {
+public:
+    explicit ReplacementTemplate(std::wstring_view replacement);
+
+    // Appends the replacement for one match. `prefixBegin` is where the text
+    // since the previous match starts. References to groups the pattern does
+    // not have expand to nothing.
+    void Append(std::wstring& output, std::wstring_view text, const RegexGroups& groups, std::size_t prefixBegin) const;
+
+private:
+    enum class PieceType {
+        Literal,
+        Group,
+        Prefix,
+        Suffix
+    };
+
+    // Literals are [offset, offset + size) of m_literals; groups use offset
+    // as the group number.
+    struct Piece {
+        PieceType type;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    void AddLiteral(std::wstring_view literal);
+
+    std::wstring m_literals;
+    std::vector<Piece> m_pieces;
+};
+
+} // namespace RenamerCore
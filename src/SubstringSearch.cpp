@@ -0,0 +1,204 @@
+#include "SubstringSearch.h"
+
+#include <cstdint>
+#include <string>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FILERENAMER_HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(FILERENAMER_HAS_X86_SIMD) && defined(__GNUC__)
+#define FILERENAMER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FILERENAMER_TARGET_AVX2
+#endif
+
+namespace {
+
+bool MiddleEquals(const wchar_t* candidate, std::wstring_view pattern) {
+    // First and last characters are already known to match.
+    if (pattern.size() <= 2) {
+        return true;
+    }
+    return std::char_traits<wchar_t>::compare(candidate + 1, pattern.data() + 1, pattern.size() - 2) == 0;
+}
+
+#ifdef FILERENAMER_HAS_X86_SIMD
+// movemask_epi8 yields one bit per byte; keep the lowest bit of every
+// wchar_t lane so each candidate position is visited once.
+constexpr std::uint32_t kLaneBits = sizeof(wchar_t) == 2 ? 0x55555555U : 0x11111111U;
+
+unsigned CountTrailingZeros(std::uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+__m128i Broadcast128(wchar_t ch) {
+    if constexpr (sizeof(wchar_t) == 2) {
+        return _mm_set1_epi16(static_cast<short>(ch));
+    } else {
+        return _mm_set1_epi32(static_cast<int>(ch));
+    }
+}
+
+__m128i Equal128(__m128i left, __m128i right) {
+    if constexpr (sizeof(wchar_t) == 2) {
+        return _mm_cmpeq_epi16(left, right);
+    } else {
+        return _mm_cmpeq_epi32(left, right);
+    }
+}
+
+FILERENAMER_TARGET_AVX2 __m256i Broadcast256(wchar_t ch) {
+    if constexpr (sizeof(wchar_t) == 2) {
+        return _mm256_set1_epi16(static_cast<short>(ch));
+    } else {
+        return _mm256_set1_epi32(static_cast<int>(ch));
+    }
+}
+
+FILERENAMER_TARGET_AVX2 __m256i Equal256(__m256i left, __m256i right) {
+    if constexpr (sizeof(wchar_t) == 2) {
+        return _mm256_cmpeq_epi16(left, right);
+    } else {
+        return _mm256_cmpeq_epi32(left, right);
+    }
+}
+
+bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesYmm) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+} // namespace
+
+namespace RenamerCore {
+
+std::size_t FindSubstringScalar(std::wstring_view text, std::wstring_view pattern) {
+    return text.find(pattern);
+}
+
+#ifdef FILERENAMER_HAS_X86_SIMD
+
+std::size_t FindSubstringSse2(std::wstring_view text, std::wstring_view pattern) {
+    constexpr std::size_t kLanes = sizeof(__m128i) / sizeof(wchar_t);
+    if (pattern.empty() || text.size() < kLanes + pattern.size() - 1) {
+        return text.find(pattern);
+    }
+
+    const std::size_t lastOffset = pattern.size() - 1;
+    const std::size_t positionCount = text.size() - lastOffset;
+    const __m128i first = Broadcast128(pattern.front());
+    const __m128i last = Broadcast128(pattern.back());
+    const wchar_t* const data = text.data();
+
+    // The final block is shifted back to end exactly at the last candidate;
+    // lanes already covered by the previous block are masked out.
+    for (std::size_t position = 0; position < positionCount; position += kLanes) {
+        std::uint32_t skipMask = 0;
+        if (position + kLanes > positionCount) {
+            const std::size_t shifted = positionCount - kLanes;
+            skipMask = (1U << ((position - shifted) * sizeof(wchar_t))) - 1;
+            position = shifted;
+        }
+
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + lastOffset));
+        const __m128i candidates = _mm_and_si128(Equal128(first, blockFirst), Equal128(last, blockLast));
+
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(candidates)) & kLaneBits & ~skipMask;
+        while (mask != 0) {
+            const std::size_t candidate = position + CountTrailingZeros(mask) / sizeof(wchar_t);
+            if (MiddleEquals(data + candidate, pattern)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return std::wstring_view::npos;
+}
+
+FILERENAMER_TARGET_AVX2 std::size_t FindSubstringAvx2(std::wstring_view text, std::wstring_view pattern) {
+    constexpr std::size_t kLanes = sizeof(__m256i) / sizeof(wchar_t);
+    if (pattern.empty() || text.size() < kLanes + pattern.size() - 1) {
+        return FindSubstringSse2(text, pattern);
+    }
+
+    const std::size_t lastOffset = pattern.size() - 1;
+    const std::size_t positionCount = text.size() - lastOffset;
+    const __m256i first = Broadcast256(pattern.front());
+    const __m256i last = Broadcast256(pattern.back());
+    const wchar_t* const data = text.data();
+
+    for (std::size_t position = 0; position < positionCount; position += kLanes) {
+        std::uint32_t skipMask = 0;
+        if (position + kLanes > positionCount) {
+            const std::size_t shifted = positionCount - kLanes;
+            skipMask = (1U << ((position - shifted) * sizeof(wchar_t))) - 1;
+            position = shifted;
+        }
+
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position + lastOffset));
+        const __m256i candidates = _mm256_and_si256(Equal256(first, blockFirst), Equal256(last, blockLast));
+
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(candidates)) & kLaneBits & ~skipMask;
+        while (mask != 0) {
+            const std::size_t candidate = position + CountTrailingZeros(mask) / sizeof(wchar_t);
+            if (MiddleEquals(data + candidate, pattern)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return std::wstring_view::npos;
+}
+
+SubstringSearchFunction GetSubstringSearch() {
+    static const SubstringSearchFunction search = CpuSupportsAvx2() ? FindSubstringAvx2 : FindSubstringSse2;
+    return search;
+}
+
+#else
+
+std::size_t FindSubstringSse2(std::wstring_view text, std::wstring_view pattern) {
+    return FindSubstringScalar(text, pattern);
+}
+
+std::size_t FindSubstringAvx2(std::wstring_view text, std::wstring_view pattern) {
+    return FindSubstringScalar(text, pattern);
+}
+
+SubstringSearchFunction GetSubstringSearch() {
+    return FindSubstringScalar;
+}
+
+#endif
+
+} // namespace RenamerCore
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace RenamerCore {
+
+// Position of the first occurrence of a non-empty `pattern` in `text`, or npos.
+using SubstringSearchFunction = std::size_t (*)(std::wstring_view text, std::wstring_view pattern);
+
+// Vectorized kernels compare the first and the last pattern character at a
+// whole register of candidate positions at once and only verify the middle
+// where both match. They exist on x86-64 only; elsewhere, and for texts
+// shorter than one register, the scalar search is used.
+std::size_t FindSubstringScalar(std::wstring_view text, std::wstring_view pattern);
+std::size_t FindSubstringSse2(std::wstring_view text, std::wstring_view pattern);
+std::size_t FindSubstringAvx2(std::wstring_view text, std::wstring_view pattern);
+
+// The fastest kernel the CPU supports, detected once.
+SubstringSearchFunction GetSubstringSearch();
+
+} // namespace RenamerCore
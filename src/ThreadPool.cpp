@@ -0,0 +1,202 @@
+#include "ThreadPool.h"
+
+#include <chrono>
+
+namespace RenamerCore {
+
+namespace {
+
+struct WorkerIdentity {
+    const void* pool = nullptr;
+    std::size_t index = 0;
+};
+
+thread_local WorkerIdentity t_worker;
+
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    m_queues.reserve(threadCount);
+    for (std::size_t index = 0; index < threadCount; ++index) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    m_workers.reserve(threadCount);
+    for (std::size_t index = 0; index < threadCount; ++index) {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this, index);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+    // The count is raised before the task becomes visible so that taking it
+    // can never drive the count below zero.
+    if (t_worker.pool == this) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queuedCount.fetch_add(1);
+        }
+        WorkerQueue& own = *m_queues[t_worker.index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedCount.fetch_add(1);
+        m_injected.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+bool ThreadPool::TryTake(std::function<void()>& task) {
+    const bool isWorker = t_worker.pool == this;
+    const std::size_t self = isWorker ? t_worker.index : 0;
+
+    if (isWorker) {
+        WorkerQueue& own = *m_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queuedCount.fetch_sub(1);
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_injected.empty()) {
+            task = std::move(m_injected.front());
+            m_injected.pop_front();
+            m_queuedCount.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (std::size_t offset = 1; offset <= m_queues.size(); ++offset) {
+        const std::size_t victim = (self + offset) % m_queues.size();
+        if (isWorker && victim == self) {
+            continue;
+        }
+
+        WorkerQueue& queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_queuedCount.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::TryRunOne() {
+    std::function<void()> task;
+    if (!TryTake(task)) {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(std::size_t index) {
+    t_worker = { this, index };
+
+    for (;;) {
+        if (TryRunOne()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() {
+            return m_stopping || m_queuedCount.load() > 0;
+        });
+        if (m_stopping && m_queuedCount.load() == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : m_pool(pool) {
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        Wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::Run(std::function<void()> task) {
+    m_pending.fetch_add(1);
+    m_pool.Enqueue([this, task = std::move(task)]() {
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        Finish(error);
+    });
+}
+
+void TaskGroup::Wait() {
+    while (m_pending.load() > 0) {
+        if (m_pool.TryRunOne()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+            return m_pending.load() == 0;
+        });
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        error = m_error;
+        m_error = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::Finish(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (error && !m_error) {
+        m_error = error;
+    }
+    if (m_pending.fetch_sub(1) == 1) {
+        m_done.notify_all();
+    }
+}
+
+} // namespace RenamerCore
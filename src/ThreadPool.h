@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RenamerCore {
+
+// Every worker owns a deque: tasks spawned on a worker go to its own deque and
+// are taken back newest-first, idle workers steal the oldest task of another
+// worker. Tasks submitted from outside the pool go through a shared queue.
+class ThreadPool {
+public:
+    // 0 means one worker per hardware thread.
+    explicit ThreadPool(std::size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t GetThreadCount() const { return m_workers.size(); }
+
+    static ThreadPool& Shared();
+
+private:
+    friend class TaskGroup;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void Enqueue(std::function<void()> task);
+    bool TryTake(std::function<void()>& task);
+    bool TryRunOne();
+    void WorkerLoop(std::size_t index);
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::deque<std::function<void()>> m_injected;
+    std::atomic<std::size_t> m_queuedCount { 0 };
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+};
+
+// A batch of tasks on a pool. Wait() runs queued tasks on the calling thread
+// while it waits, so groups may be nested without starving the pool.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Run(std::function<void()> task);
+
+    // Rethrows the first exception raised by a task of this group.
+    void Wait();
+
+private:
+    void Finish(std::exception_ptr error);
+
+    ThreadPool& m_pool;
+    std::atomic<std::size_t> m_pending { 0 };
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::exception_ptr m_error;
+};
+
+template <typename Function>
+void ParallelFor(ThreadPool& pool, std::size_t count, Function&& function) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || pool.GetThreadCount() <= 1) {
+        for (std::size_t index = 0; index < count; ++index) {
+            function(index);
+        }
+        return;
+    }
+
+    TaskGroup group(pool);
+    for (std::size_t index = 0; index < count; ++index) {
+        group.Run([&function, index]() {
+            function(index);
+        });
+    }
+    group.Wait();
+}
+
+} // namespace RenamerCore
@@ -0,0 +1,45 @@
+#include "RegexAutomaton.h"
+#include "RegexEngine.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Case-insensitive class escapes must agree with std::wregex: negated
+// escapes inside a class are not case-folded, and U+0130, which lowercases
+// to "i", is not a word character.
+int main() {
+    const std::vector<std::wstring> patterns = {
+        L"[\\W]", L"[^\\W]", L"[\\w]", L"[^\\w]", L"\\W", L"\\w", L"[\\W_]", L"[^\\W_]", L"[\\d\\W]"
+    };
+
+    std::vector<wchar_t> characters = { 0x0130, 0x212A, 0x017F };
+    for (wchar_t ch = L'A'; ch <= L'Z'; ++ch) {
+        characters.push_back(ch);
+        characters.push_back(static_cast<wchar_t>(ch - L'A' + L'a'));
+    }
+
+    int failures = 0;
+    for (const std::wstring& pattern : patterns) {
+        const std::unique_ptr<RenamerCore::RegexEngine> automaton = RenamerCore::CompileAutomatonRegex(pattern, true);
+        const std::unique_ptr<RenamerCore::RegexEngine> reference = RenamerCore::CompileStdRegex(pattern, true);
+        if (!automaton) {
+            std::fprintf(stderr, "%ls: not compiled by the automaton\n", pattern.c_str());
+            ++failures;
+            continue;
+        }
+
+        for (const wchar_t ch : characters) {
+            const std::wstring text(1, ch);
+            const bool actual = automaton->IsMatch(text);
+            const bool expected = reference->IsMatch(text);
+            if (actual != expected) {
+                std::fprintf(stderr, "%ls on U+%04X: automaton=%d std::wregex=%d\n",
+                             pattern.c_str(), static_cast<unsigned>(ch), actual, expected);
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}